@@ -0,0 +1,45 @@
+#ifndef BENCHMARK
+#define BENCHMARK
+
+#define MAX_SWEEP 64                    // Values of each list of the sweep
+
+struct benchmark_options {
+    int algorithms[MAX_SWEEP];          // --algorithms list (0-5 by default)
+    int num_algorithms;
+    int precisions[MAX_SWEEP];          // --precisions list
+    int num_precisions;
+    int threads[MAX_SWEEP];             // --threads list (powers of two up to the processors by default)
+    int num_threads;
+    int warmups;                        // --warmups n
+    int repetitions;                    // --repetitions n
+    char * csv_file;                    // --csv file
+    char * json_file;                   // --json file
+    char * baseline_file;               // --baseline file|auto (CSV of a previous benchmark)
+    double tolerance;                   // --tolerance percent
+    double significance;                // --significance p
+};
+
+struct benchmark_result {
+    int algorithm;
+    int precision;
+    int threads;
+    int iterations;
+    double median;                      // Seconds of the repetitions
+    double min;
+    double max;
+    double mean;
+    double stddev;
+    int decimals;                       // Decimals that match (last repetition)
+    double * times;                     // Seconds of every repetition (sorted by get_statistics)
+};
+
+int parse_list(char * list, int * values);
+int parse_benchmark_options(int argc, char ** argv, struct benchmark_options * options);
+void print_benchmark_usage();
+int benchmark_iterations(int algorithm, int precision);
+int compare_times(const void * a, const void * b);
+void get_statistics(struct benchmark_result * result, double * times, int num_times);
+void get_cpu_model(char * cpu, int size);
+int run_benchmark(struct benchmark_options * options);
+
+#endif
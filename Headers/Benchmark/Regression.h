@@ -0,0 +1,30 @@
+#ifndef REGRESSION
+#define REGRESSION
+
+#define BOOTSTRAP_SAMPLES 2000              // Resamples of the confidence intervals
+#define EXACT_LIMIT 2500                    // Highest product of the sizes with the exact Mann-Whitney test
+
+struct baseline_case {
+    int algorithm;
+    int precision;
+    int threads;
+    int num_times;
+    double * times;                     // Seconds of every repetition
+};
+
+struct baseline {
+    char revision[64];
+    char cpu[256];
+    long processors;
+    int num_cases;
+    struct baseline_case * cases;
+};
+
+int read_baseline(char * file_name, struct baseline * baseline);
+void free_baseline(struct baseline * baseline);
+double mann_whitney(double * x, int m, double * y, int n);
+void bootstrap_ratio(double * x, int m, double * y, int n, double * low, double * high);
+void get_baseline_name(char * cpu, char * file_name, int size);
+int compare_baseline(struct benchmark_options * options, struct benchmark_result * results, int num_results, char * cpu);
+
+#endif
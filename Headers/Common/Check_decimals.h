@@ -1,7 +1,19 @@
 #ifndef CHECK_DECIMALS
 #define CHECK_DECIMALS
 
+#define DIFF_WINDOW 12                      // Characters shown at each side of the mismatch
+
+extern long check_mismatch;                 // First mismatch of the last check (-1 = none)
+extern long check_window_start;
+extern char check_computed_window[2 * DIFF_WINDOW + 2];
+extern char check_correct_window[2 * DIFF_WINDOW + 2];
+
+long first_mismatch(char * computed, char * correct, long length, int num_threads);
+long compare_correct_pi(char * computed, long length, long position);
+void print_mismatch();
+int check_decimals_string(char * calculated_pi, long bytes_of_pi);
 int check_decimals(mpf_t pi);
+int check_decimals_packed(char * file_name);
 
 #endif
 
@@ -0,0 +1,48 @@
+#ifndef CHECKPOINT
+#define CHECKPOINT
+
+#define CHECKPOINT_MAGIC 0x4b434950     // "PICK"
+#define CHECKPOINT_VERSION 2
+
+#define CHECKPOINT_BBP 0
+#define CHECKPOINT_CHUDNOVSKY 1
+#define CHECKPOINT_BELLARD 2
+
+struct checkpoint_header {
+    int magic;
+    int version;
+    int algorithm;
+    int precision;              // Bits of the values
+    int iterations;
+    int processes;              // Processes of the run (one file per process in MPI)
+    int generation;             // Times the run has been restarted
+    int slots;
+    int values;                 // Values per slot
+};
+
+struct checkpoint_slot {
+    int first;                  // Iterations first, first + stride, ... before end
+    int stride;
+    int next;                   // Next iteration to compute
+    int end;
+    int done;                   // The thread finished its iterations
+    int idle;                   // No thread is working on it yet (its values do not change)
+    int generation;             // Last request published
+    mpf_t * values;
+};
+
+int read_checkpoint(char * file_name, struct checkpoint_header * header, struct checkpoint_slot ** slots);
+void clear_checkpoint_slots(struct checkpoint_slot * slots, int num_slots, int num_values);
+void init_checkpoint_file(char * file_name, int algorithm, int num_iterations, int max_slots,
+                            int required_slots, int num_values, int num_procs, int generation);
+void check_checkpoint_options();
+void init_checkpoint(int algorithm, int num_iterations, int num_slots, int num_values);
+int open_checkpoint_slot(int first, int stride, int next, int end, mpf_ptr * values);
+int resume_checkpoint(int first, int * next, int * end, mpf_ptr * values);
+void checkpoint_poll(int slot, int next, mpf_ptr * values);
+void checkpoint_done(int slot, mpf_ptr * values);
+void checkpoint_idle(int slot, int idle);
+void save_checkpoint();
+void finish_checkpoint();
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef CONVERSION
+#define CONVERSION
+
+void word_to_digits(char * out, uint64_t word);
+void mpz_to_digits(char * out, mpz_t value, long digits, int num_threads);
+void mpz_to_words(uint64_t * out, mpz_t value, long num_words, int num_threads);
+long get_mpf_decimals(mpf_t value);
+char * mpf_to_decimal_string(mpf_t value, long num_decimals, int num_threads, long * length);
+
+#endif
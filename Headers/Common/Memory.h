@@ -0,0 +1,30 @@
+#ifndef MEMORY
+#define MEMORY
+
+#define OP_MUL 0                        // mpf_mul, mpf_mul_ui
+#define OP_DIV 1                        // mpf_div, mpf_div_ui
+#define OP_ADD 2                        // mpf_add, mpf_add_ui, mpf_sub
+#define NUM_OPS 3
+
+struct memory_counters {
+    long allocations;
+    long reallocations;
+    long frees;
+    long bytes;                         // Bytes allocated (and added by the reallocations)
+    long peak;                          // Highest bytes in use
+    long ops[NUM_OPS];
+};
+
+extern int memory_enabled;
+extern int memory_ops_counted;
+extern struct memory_counters memory_phases[NUM_PHASES];
+extern struct memory_counters memory_total;
+
+void start_memory_accounting();
+void reset_memory_counters();
+void account_phase_memory(int phase);
+void count_op(int op);
+void collect_memory_counters();
+void print_memory(int detailed);
+
+#endif
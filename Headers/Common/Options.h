@@ -0,0 +1,39 @@
+#ifndef OPTIONS
+#define OPTIONS
+
+#define EQUAL_DISTRIBUTION 0
+#define WEIGHTED_DISTRIBUTION 1
+#define DYNAMIC_DISTRIBUTION 2
+
+#define DECIMAL_FORMAT 0
+#define HEX_FORMAT 1
+#define PACKED_FORMAT 2
+#define PACKED_HEX_FORMAT 3
+#define REFERENCE_FORMAT 4
+
+struct options {
+    int distribution;               // --distribution equal|weighted|dynamic
+    char * calibration_file;        // --calibration file
+    int overlap;                    // --overlap
+    int shm;                        // --shm
+    char * checkpoint_file;         // --checkpoint file
+    int checkpoint_interval;        // --checkpoint-interval seconds
+    int resume;                     // --resume
+    char * output_file;             // --output file
+    int output_format;              // --format dec|hex|packed|packed-hex|reference
+    long digits_per_file;           // --digits-per-file n
+    char * reference_file;          // --reference file
+    char * report_file;             // --report file
+    int imbalance;                  // --imbalance
+    char * trace_file;              // --trace file
+    int memory;                     // --memory
+    int perf;                       // --perf
+};
+
+extern struct options run_options;
+
+int parse_options(int argc, char ** argv, int first_option);
+void print_options_usage();
+
+#endif
+
@@ -0,0 +1,23 @@
+#ifndef OUTPUT
+#define OUTPUT
+
+struct output_sink {
+    char * file_name;
+    long per_file;                  // Characters of each file (0 = one file)
+    char * name;                    // Current file
+    int fd;
+    int file_index;
+    long file_offset;               // Characters written in the current file
+    long position;                  // Characters written in all the files
+    char * buffer;                  // Chunk not written yet
+    long buffered;
+    FILE * index;
+    int error;
+};
+
+int open_output_sink(struct output_sink * sink, char * file_name, long per_file);
+void write_output_sink(struct output_sink * sink, char * text, long length);
+int close_output_sink(struct output_sink * sink);
+int write_and_check_decimals(mpf_t pi, long num_decimals);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef PACKED
+#define PACKED
+
+#define PACKED_MAGIC 0x50444950         // "PIDP"
+#define PACKED_VERSION 1
+#define PACKED_BLOCK_WORDS 65536
+
+struct packed_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t base;                      // 10 or 16
+    uint32_t digits_per_word;           // 19 or 16
+    uint64_t int_part;                  // Integer part of the number
+    uint64_t num_digits;                // Digits after the point
+    uint64_t num_words;
+    uint64_t block_words;
+    uint64_t num_blocks;
+    uint64_t data_offset;               // Offset of the first word in the file
+};
+
+struct packed_block {
+    uint64_t offset;                    // Offset of its first word in the file
+    uint64_t first_digit;
+    uint64_t num_words;
+    uint64_t checksum;                  // FNV-1a of its words
+};
+
+struct packed_file {
+    int fd;
+    size_t size;
+    char * map;                         // The whole file (mmap)
+    struct packed_header * header;
+    struct packed_block * blocks;
+    uint64_t * words;
+};
+
+int write_packed_file(char * file_name, mpf_t value, long num_digits, int base, int num_threads);
+int open_packed(char * file_name, struct packed_file * packed);
+void close_packed(struct packed_file * packed);
+long verify_packed(struct packed_file * packed);
+void packed_word_to_digits(char * out, uint64_t word, int base);
+long read_packed_digits(int fd, struct packed_header * header, long first, long count, char * out);
+
+#endif
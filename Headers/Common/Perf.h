@@ -0,0 +1,29 @@
+#ifndef PERF
+#define PERF
+
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_LLC_MISSES 2
+#define PERF_BRANCH_MISSES 3
+#define NUM_PERF_EVENTS 4
+#define PERF_STARTS 64                  // Readings of the last phase starts of each thread
+
+struct perf_counters {
+    long values[NUM_PERF_EVENTS];
+};
+
+extern int perf_enabled;
+extern int perf_available[NUM_PERF_EVENTS];
+extern struct perf_counters perf_phases[NUM_PHASES];
+extern struct perf_counters perf_total;
+extern char * perf_keys[NUM_PERF_EVENTS];
+
+void start_perf_counters();
+void open_perf_counters();
+void start_phase_perf(double start);
+void reset_perf_counters();
+void account_phase_perf(int phase, double start);
+void collect_perf_counters();
+void print_perf(int detailed);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef PIPELINE
+#define PIPELINE
+
+int pipeline_check_decimals(mpf_t pi, char * file_name, long per_file, long num_decimals);
+
+#endif
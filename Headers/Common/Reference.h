@@ -0,0 +1,24 @@
+#ifndef REFERENCE
+#define REFERENCE
+
+#define REFERENCE_MAGIC 0x52484950      // "PIHR"
+#define REFERENCE_VERSION 1
+#define REFERENCE_CHUNK (1 << 16)       // Digits of each hashed chunk
+
+struct reference_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t int_part;                  // Integer part of the number
+    uint64_t num_digits;                // Digits after the point
+    uint64_t chunk_digits;
+    uint64_t num_chunks;
+    uint64_t checksum;                  // Hash of the hashes of the chunks
+};
+
+uint64_t hash_digits(char * digits, long length);
+int write_reference_hashes(char * file_name, int num_threads);
+long reference_length();
+long read_reference(long position, long count, char * out);
+long compare_reference(char * computed, long length, long position);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef TIMERS
+#define TIMERS
+
+#define PHASE_SETUP 0                   // Precision and variables of the calculator
+#define PHASE_INIT 1                    // Factorials and seeds of the blocks
+#define PHASE_SERIES 2
+#define PHASE_THREAD_REDUCTION 3
+#define PHASE_MPI_REDUCTION 4
+#define PHASE_FINAL 5                   // Last operations (sqrt, division)
+#define PHASE_CONVERSION 6
+#define PHASE_CHECK 7
+#define NUM_PHASES 8
+#define MAX_WORK_THREADS 1024
+
+struct thread_work {
+    int first;                          // First iteration of its first block
+    int end;                            // End of its last block
+    int stride;                         // Distance between its iterations
+    int blocks;
+    long iterations;
+    double busy;                        // Seconds computing (seeds and series)
+    double wait;                        // Seconds adding its sum to the result
+};
+
+extern double phase_seconds[NUM_PHASES];
+extern char * phase_names[NUM_PHASES];
+extern char * phase_keys[NUM_PHASES];
+extern struct thread_work work_threads[MAX_WORK_THREADS];
+extern int work_num_threads;
+
+double phase_clock();
+double phase_add(int phase, double start);
+void reset_phases();
+void save_phases(double * saved);
+void restore_phases(double * saved);
+void print_phases();
+void record_thread_work(int thread_id, int first, int end, int stride, double busy, double wait);
+void reset_thread_work();
+double get_imbalance(struct thread_work * threads, int num_threads);
+void print_thread_work(struct thread_work * threads, int num_threads, int proc_id);
+void print_imbalance(int detailed);
+void write_run_report(char * file_name, char * version, int algorithm, int precision, int num_iterations,
+                        int num_procs, int num_threads, double execution_time, int decimals);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef TRACE
+#define TRACE
+
+#define TRACE_EVENTS (1 << 14)          // Events kept by each thread (the oldest are overwritten)
+#define MAX_TRACE_THREADS 1024
+#define TRACE_NAME 24
+
+struct trace_event {
+    char name[TRACE_NAME];
+    int process;
+    int thread;                         // Order of the first event of the thread in its process
+    double start;                       // Seconds of the monotonic clock
+    double duration;
+};
+
+extern int trace_enabled;
+
+void start_trace();
+void trace_event(char * name, double start);
+long collect_trace(struct trace_event ** events, int process, double offset);
+int write_trace(char * file_name, struct trace_event * events, long num_events);
+void save_trace(char * file_name);
+
+#endif
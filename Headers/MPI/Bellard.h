@@ -1,6 +1,8 @@
 #ifndef BELLARD_MPI
 #define BELLARD_MPI
 
+void Bellard_progression_MPI(mpf_t sum, int slot, int next, int stride, int end);
+void Bellard_block_MPI(mpf_t local_proc_pi, int block_start, int block_end, int num_threads);
 void Bellard_algorithm_MPI(int num_procs, int proc_id, mpf_t pi, 
                                 int num_iterations, int num_threads);
 
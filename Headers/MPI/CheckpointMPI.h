@@ -0,0 +1,9 @@
+#ifndef CHECKPOINT_MPI
+#define CHECKPOINT_MPI
+
+char * get_checkpoint_name_MPI(int proc_id);
+void init_checkpoint_MPI(int num_procs, int proc_id, int algorithm, int num_iterations, int max_slots);
+int restart_MPI(int num_procs, int proc_id, mpf_t local_proc_pi, int algorithm, int num_iterations,
+                    int num_threads, void (*compute_progression)(mpf_t, int, int, int, int));
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef CHUDNOVSKY_MPI
 #define CHUDNOVSKY_MPI
 
+void Chudnovsky_progression_MPI(mpf_t sum, int slot, int next, int stride, int end);
 void Chudnovsky_algorithm_MPI(int num_procs, int proc_id, mpf_t pi, int num_iterations, int num_threads);
 
 #endif
@@ -0,0 +1,12 @@
+#ifndef DISTRIBUTION_MPI
+#define DISTRIBUTION_MPI
+
+double get_throughput(int proc_id, int num_iterations, int num_threads, void (*compute_block)(mpf_t, int, int, int));
+void get_process_block(int num_procs, int proc_id, int num_iterations, int num_threads, 
+                        void (*compute_block)(mpf_t, int, int, int), int * block);
+void compute_dynamic_blocks(mpf_t local_proc_pi, int pool_start, int num_iterations, 
+                        int num_procs, int num_threads, void (*compute_block)(mpf_t, int, int, int));
+int get_max_blocks(int num_procs);
+
+#endif
+
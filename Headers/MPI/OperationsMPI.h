@@ -5,6 +5,11 @@ void add(void *, void *, int *, MPI_Datatype *);
 void mul(void *, void *, int *, MPI_Datatype *);
 int pack(void *, mpf_t);
 void unpack(void *, mpf_t);
+void mpf_to_fixed(mp_limb_t *, int, long, mpf_t);
+void fixed_to_mpf(mpf_t, mp_limb_t *, int, long);
+void get_fixed_window(long *, mp_limb_t *, int);
+void reduce_sum(mpf_t, mpf_t, MPI_Comm);
+void reduce_sum_shm(mpf_t, mpf_t, MPI_Comm);
 
 #endif
 
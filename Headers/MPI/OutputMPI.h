@@ -0,0 +1,7 @@
+#ifndef OUTPUT_MPI
+#define OUTPUT_MPI
+
+int write_decimals_MPI(char * file_name, mpf_t pi, int num_decimals, int proc_id, int num_procs, int num_threads);
+void print_output_MPI(char * file_name, int num_decimals);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef OVERLAP_MPI
+#define OVERLAP_MPI
+
+void init_overlap_MPI(int num_threads);
+int reduce_thread_pi_MPI(int thread_id, mpf_t local_thread_pi);
+void finish_overlap_MPI(mpf_t pi, int proc_id);
+void print_overlap_MPI();
+
+#endif
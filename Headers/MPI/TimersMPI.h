@@ -0,0 +1,6 @@
+#ifndef TIMERS_MPI
+#define TIMERS_MPI
+
+void print_imbalance_MPI(int proc_id, int num_procs, double reduction_time, int detailed);
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef TRACE_MPI
+#define TRACE_MPI
+
+double get_clock_offset_MPI(int proc_id, int num_procs);
+void save_trace_MPI(char * file_name, int proc_id, int num_procs);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef MICROBENCHMARK
+#define MICROBENCHMARK
+
+#define NUM_KERNELS 10
+
+struct microbenchmark_options {
+    int kernels[MAX_SWEEP];             // --kernels list (0-9 by default)
+    int num_kernels;
+    int precisions[MAX_SWEEP];          // --precisions list
+    int num_precisions;
+    int repetitions;                    // --repetitions n (samples of each case)
+    double min_time;                    // --min-time seconds (of each sample)
+    int cpu;                            // --cpu n (-1 = not pinned)
+    char * csv_file;                    // --csv file
+    char * json_file;                   // --json file
+};
+
+struct kernel_result {
+    int kernel;
+    int precision;
+    int n;                              // Iteration computed by the kernel
+    long limbs;                         // Limbs of the mpf_t values
+    long calls;                         // Calls of each sample
+    struct benchmark_result time;       // Nanoseconds per call of the samples
+};
+
+int parse_microbenchmark_options(int argc, char ** argv, struct microbenchmark_options * options);
+void print_microbenchmark_usage();
+void run_microbenchmark(struct microbenchmark_options * options);
+
+#endif
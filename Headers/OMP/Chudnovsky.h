@@ -3,6 +3,7 @@
 
 void Chudnovsky_algorithm_OMP(mpf_t pi, int num_iterations, int num_threads);
 void init_dep_a(mpf_t dep_a, int block_start);
+void init_block_seeds_OMP(mpf_t dep_a, mpf_t dep_b, mpf_t c, int block_start, int block_end);
 
 #endif
 
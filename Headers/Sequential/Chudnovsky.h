@@ -3,6 +3,7 @@
 
 void Chudnovsky_algorithm(mpf_t, int);
 void Chudnovsky_iteration(mpf_t, int, mpf_t, mpf_t, mpf_t, mpf_t);
+void get_dep_a_ratio(mpf_t, int, int);
 
 #endif
 
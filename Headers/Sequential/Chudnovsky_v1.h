@@ -4,7 +4,8 @@
 void Chudnovsky_iteration_v1(mpf_t, int, mpf_t, mpf_t, mpf_t, mpf_t, mpf_t, mpf_t, mpf_t);
 void Chudnovsky_algorithm_v1(mpf_t, int);
 void get_factorials(mpf_t *, int);
-void clear_factorials(mpf_t *, int);
+void next_factorials(mpf_t *, int);
+void clear_factorials(mpf_t *);
 
 
 #endif
@@ -0,0 +1,366 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <gmp.h>
+#include "../../Headers/OMP/BBP.h"
+#include "../../Headers/OMP/BBP_v1.h"
+#include "../../Headers/OMP/Bellard_v1.h"
+#include "../../Headers/OMP/Bellard.h"
+#include "../../Headers/OMP/Chudnovsky_v1.h"
+#include "../../Headers/OMP/Chudnovsky.h"
+#include "../../Headers/Common/Check_decimals.h"
+#include "../../Headers/Benchmark/Benchmark.h"
+#include "../../Headers/Benchmark/Regression.h"
+
+#ifndef GIT_REVISION
+#define GIT_REVISION "unknown"              // Set by compile.sh
+#endif
+
+
+/************************************************************************************
+ * Benchmark of the algorithms (OMP versions)                                       *
+ * It runs every combination of the algorithms, precisions and numbers of threads   *
+ * of the options in the same process: first the warmups, which are not measured,   *
+ * and then the repetitions. The median, minimum, maximum, mean and standard        *
+ * deviation of the repetitions are printed and saved as CSV and/or JSON, with the  *
+ * git revision of the build and the model of the processor.                        *
+ * With --baseline, the times are compared with the ones of a previous CSV (see     *
+ * Regression) and the benchmark fails if any case is significantly slower or       *
+ * cannot be compared.                                                              *
+ * The algorithms are run with the OMP versions, so one thread is the sequential    *
+ * case. The processes of the MPI version are measured running it with mpirun.      *
+ *                                                                                  *
+ ************************************************************************************/
+
+struct benchmark_algorithm {
+    char * name;
+    void (* run)(mpf_t pi, int num_iterations, int num_threads);
+};
+
+struct benchmark_algorithm benchmark_algorithms[] = {
+    {"BBP (First version)", BBP_algorithm_v1_OMP},
+    {"BBP (Last version)", BBP_algorithm_OMP},
+    {"Bellard (First version)", Bellard_algorithm_v1_OMP},
+    {"Bellard (Last version)", Bellard_algorithm_OMP},
+    {"Chudnovsky (Computing all factorials)", Chudnovsky_algorithm_v1_OMP},
+    {"Chudnovsky (Does not compute all factorials)", Chudnovsky_algorithm_OMP}
+};
+
+
+/*
+ * Reads a list of numbers "1,2,8" (or ranges "0-5") in values.
+ * It returns the number of values, or -1 if the list is not correct.
+ */
+int parse_list(char * list, int * values){
+    int num_values, first, last;
+    char * end;
+
+    num_values = 0;
+    while(*list != '\0'){
+        first = strtol(list, &end, 10);
+        if (end == list) return -1;
+        last = first;
+        if (*end == '-'){
+            list = end + 1;
+            last = strtol(list, &end, 10);
+            if (end == list || last < first) return -1;
+        }
+        for(; first <= last; first++){
+            if (num_values == MAX_SWEEP) return -1;
+            values[num_values++] = first;
+        }
+        list = end;
+        if (*list == ',') list++;
+        else if (*list != '\0') return -1;
+    }
+    return num_values;
+}
+
+/*
+ * Reads the options, given as pairs "--name value", with their default values.
+ * It returns 0 if every option is correct and -1 otherwise.
+ */
+int parse_benchmark_options(int argc, char ** argv, struct benchmark_options * options){
+    int i, a, processors;
+    char * name, * value;
+
+    options -> num_algorithms = parse_list("0-5", options -> algorithms);
+    options -> num_precisions = parse_list("1000,10000", options -> precisions);
+    processors = sysconf(_SC_NPROCESSORS_ONLN);
+    options -> num_threads = 0;
+    for(i = 1; i <= processors && options -> num_threads < MAX_SWEEP; i *= 2) options -> threads[options -> num_threads++] = i;
+    options -> warmups = 1;
+    options -> repetitions = 5;
+    options -> csv_file = NULL;
+    options -> json_file = NULL;
+    options -> baseline_file = NULL;
+    options -> tolerance = 5;
+    options -> significance = 0.05;
+
+    for(i = 1; i < argc; i++){
+        name = argv[i];
+        if (i + 1 >= argc) return -1;
+        value = argv[++i];
+
+        if (strcmp(name, "--algorithms") == 0){
+            options -> num_algorithms = parse_list(value, options -> algorithms);
+            if (options -> num_algorithms <= 0) return -1;
+            for(a = 0; a < options -> num_algorithms; a++){
+                if (options -> algorithms[a] < 0 || options -> algorithms[a] > 5) return -1;
+            }
+
+        } else if (strcmp(name, "--precisions") == 0){
+            options -> num_precisions = parse_list(value, options -> precisions);
+            if (options -> num_precisions <= 0) return -1;
+
+        } else if (strcmp(name, "--threads") == 0){
+            options -> num_threads = parse_list(value, options -> threads);
+            if (options -> num_threads <= 0) return -1;
+
+        } else if (strcmp(name, "--warmups") == 0){
+            options -> warmups = atoi(value);
+            if (options -> warmups < 0) return -1;
+
+        } else if (strcmp(name, "--repetitions") == 0){
+            options -> repetitions = atoi(value);
+            if (options -> repetitions <= 0) return -1;
+
+        } else if (strcmp(name, "--csv") == 0){
+            options -> csv_file = value;
+
+        } else if (strcmp(name, "--json") == 0){
+            options -> json_file = value;
+
+        } else if (strcmp(name, "--baseline") == 0){
+            options -> baseline_file = value;
+
+        } else if (strcmp(name, "--tolerance") == 0){
+            options -> tolerance = atof(value);
+            if (options -> tolerance < 0) return -1;
+
+        } else if (strcmp(name, "--significance") == 0){
+            options -> significance = atof(value);
+            if (options -> significance <= 0 || options -> significance >= 1) return -1;
+
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void print_benchmark_usage(){
+    printf("  Options: \n");
+    printf("    --algorithms list -> Algorithms to run, as \"0,2,4\" or \"0-5\" (all by default) \n");
+    printf("    --precisions list -> Precisions to run (1000,10000 by default) \n");
+    printf("    --threads list -> Numbers of threads (powers of two up to the processors by default) \n");
+    printf("    --warmups n -> Runs of each case that are not measured (1 by default) \n");
+    printf("    --repetitions n -> Measured runs of each case (5 by default) \n");
+    printf("    --csv file -> Save the results as CSV \n");
+    printf("    --json file -> Save the results as JSON \n");
+    printf("    --baseline file|auto -> Compare the times with a previous CSV (auto = Resources/Baselines/<processor>.csv) \n");
+    printf("                            and fail if any case is slower, is not in it or has too few repetitions \n");
+    printf("    --tolerance percent -> Slowdown allowed by --baseline (5 by default) \n");
+    printf("    --significance p -> Significance of the Mann-Whitney test of --baseline (0.05 by default) \n");
+}
+
+/*
+ * Returns the iterations of the algorithm for the precision, as calculate_Pi_OMP
+ */
+int benchmark_iterations(int algorithm, int precision){
+    if (algorithm <= 1) return precision * 0.84;
+    if (algorithm <= 3) return precision / 3;
+    return (precision + 14 - 1) / 14;
+}
+
+/*
+ * Runs the algorithm once and returns its execution time in seconds.
+ * If check is not 0, it also stores the decimals that match in decimals.
+ */
+double run_once(int algorithm, int precision, int num_threads, int check, int * decimals){
+    struct timespec t1, t2;
+    mpf_t pi;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    mpf_set_default_prec(precision * 8);
+    mpf_init_set_ui(pi, 0);
+    benchmark_algorithms[algorithm].run(pi, benchmark_iterations(algorithm, precision), num_threads);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    if (check) *decimals = check_decimals(pi);
+    mpf_clear(pi);
+
+    return (t2.tv_sec - t1.tv_sec) + (t2.tv_nsec - t1.tv_nsec) / 1.e9;
+}
+
+int compare_times(const void * a, const void * b){
+    double x = *(double *) a, y = *(double *) b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Gets the median, minimum, maximum, mean and standard deviation of the times
+ */
+void get_statistics(struct benchmark_result * result, double * times, int num_times){
+    int i;
+    double sum, squares;
+
+    qsort(times, num_times, sizeof(double), compare_times);
+    result -> median = (num_times % 2 == 1) ? times[num_times / 2] :
+                            (times[num_times / 2 - 1] + times[num_times / 2]) / 2;
+    result -> min = times[0];
+    result -> max = times[num_times - 1];
+    sum = 0;
+    for(i = 0; i < num_times; i++) sum += times[i];
+    result -> mean = sum / num_times;
+    squares = 0;
+    for(i = 0; i < num_times; i++) squares += (times[i] - result -> mean) * (times[i] - result -> mean);
+    result -> stddev = (num_times > 1) ? sqrt(squares / (num_times - 1)) : 0;
+}
+
+/*
+ * Stores the model of the processor (from /proc/cpuinfo) in cpu, without quotes
+ */
+void get_cpu_model(char * cpu, int size){
+    char line[512], * value;
+    FILE * file;
+
+    snprintf(cpu, size, "unknown");
+    file = fopen("/proc/cpuinfo", "r");
+    if (file == NULL) return;
+    while(fgets(line, sizeof(line), file) != NULL){
+        if (strncmp(line, "model name", 10) == 0 && (value = strchr(line, ':')) != NULL){
+            for(value++; *value == ' '; value++);
+            value[strcspn(value, "\n")] = '\0';
+            snprintf(cpu, size, "%s", value);
+            break;
+        }
+    }
+    fclose(file);
+    for(value = cpu; *value != '\0'; value++){
+        if (*value == '"') *value = '\'';
+    }
+}
+
+void write_csv(char * file_name, struct benchmark_result * results, int num_results,
+                    struct benchmark_options * options, char * cpu){
+    int i, r;
+    FILE * file;
+
+    file = fopen(file_name, "w");
+    if (file == NULL){
+        printf("  %s could not be written \n", file_name);
+        return;
+    }
+    fprintf(file, "revision,cpu,processors,gmp,warmups,repetitions,algorithm,name,precision,threads,iterations,"
+                    "median,min,max,mean,stddev,decimals,times\n");
+    for(i = 0; i < num_results; i++){
+        fprintf(file, "%s,\"%s\",%ld,%s,%d,%d,%d,\"%s\",%d,%d,%d,%f,%f,%f,%f,%f,%d,",
+                    GIT_REVISION, cpu, sysconf(_SC_NPROCESSORS_ONLN), gmp_version, options -> warmups,
+                    options -> repetitions, results[i].algorithm, benchmark_algorithms[results[i].algorithm].name,
+                    results[i].precision, results[i].threads, results[i].iterations, results[i].median,
+                    results[i].min, results[i].max, results[i].mean, results[i].stddev, results[i].decimals);
+        for(r = 0; r < options -> repetitions; r++){
+            fprintf(file, "%.9f%s", results[i].times[r], (r < options -> repetitions - 1) ? ";" : "\n");
+        }
+    }
+    fclose(file);
+}
+
+void write_json(char * file_name, struct benchmark_result * results, int num_results,
+                    struct benchmark_options * options, char * cpu){
+    int i, r;
+    FILE * file;
+
+    file = fopen(file_name, "w");
+    if (file == NULL){
+        printf("  %s could not be written \n", file_name);
+        return;
+    }
+    fprintf(file, "{\n  \"revision\": \"%s\",\n  \"cpu\": \"%s\",\n  \"processors\": %ld,\n  \"gmp\": \"%s\",\n",
+                GIT_REVISION, cpu, sysconf(_SC_NPROCESSORS_ONLN), gmp_version);
+    fprintf(file, "  \"warmups\": %d,\n  \"repetitions\": %d,\n  \"results\": [\n", options -> warmups, options -> repetitions);
+    for(i = 0; i < num_results; i++){
+        fprintf(file, "    {\"algorithm\": %d, \"name\": \"%s\", \"precision\": %d, \"threads\": %d, \"iterations\": %d, "
+                        "\"median\": %f, \"min\": %f, \"max\": %f, \"mean\": %f, \"stddev\": %f, \"decimals\": %d, \"times\": [",
+                    results[i].algorithm, benchmark_algorithms[results[i].algorithm].name, results[i].precision,
+                    results[i].threads, results[i].iterations, results[i].median, results[i].min, results[i].max,
+                    results[i].mean, results[i].stddev, results[i].decimals);
+        for(r = 0; r < options -> repetitions; r++){
+            fprintf(file, "%.9f%s", results[i].times[r], (r < options -> repetitions - 1) ? ", " : "");
+        }
+        fprintf(file, "]}%s\n", (i < num_results - 1) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+}
+
+/*
+ * Runs the benchmark and returns the number of cases that fail the baseline of the
+ * options (0 without baseline), or -1 if the baseline could not be read.
+ */
+int run_benchmark(struct benchmark_options * options){
+    int a, p, t, r, num_results, decimals, slower;
+    double * times;
+    char cpu[256];
+    struct benchmark_result * results, * result;
+
+    get_cpu_model(cpu, sizeof(cpu));
+    printf("  Revision: %s \n", GIT_REVISION);
+    printf("  Processor: %s (%ld online) \n", cpu, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("  Warmups: %d, repetitions: %d \n", options -> warmups, options -> repetitions);
+    printf("\n");
+    printf("  %-9s %-9s %-7s %-10s %-10s %-10s %-10s %-8s \n",
+                "Algorithm", "Precision", "Threads", "Median", "Min", "Max", "Stddev", "Decimals");
+
+    num_results = options -> num_algorithms * options -> num_precisions * options -> num_threads;
+    results = malloc(sizeof(struct benchmark_result) * num_results);
+    times = malloc(sizeof(double) * options -> repetitions * num_results);
+    num_results = 0;
+    for(a = 0; a < options -> num_algorithms; a++){
+        for(p = 0; p < options -> num_precisions; p++){
+            for(t = 0; t < options -> num_threads; t++){
+                result = &results[num_results];
+                result -> times = times + num_results * options -> repetitions;
+                result -> algorithm = options -> algorithms[a];
+                result -> precision = options -> precisions[p];
+                result -> threads = options -> threads[t];
+                result -> iterations = benchmark_iterations(result -> algorithm, result -> precision);
+                if (result -> precision <= 0 || result -> threads <= 0 || result -> iterations < result -> threads){
+                    printf("  %-9d %-9d %-7d skipped (too few iterations for the threads) \n",
+                                result -> algorithm, result -> precision, result -> threads);
+                    continue;
+                }
+
+                for(r = 0; r < options -> warmups; r++){
+                    run_once(result -> algorithm, result -> precision, result -> threads, 0, &decimals);
+                }
+                for(r = 0; r < options -> repetitions; r++){
+                    result -> times[r] = run_once(result -> algorithm, result -> precision, result -> threads,
+                                            r == options -> repetitions - 1, &result -> decimals);
+                }
+                get_statistics(result, result -> times, options -> repetitions);
+                printf("  %-9d %-9d %-7d %-10f %-10f %-10f %-10f %-8d \n", result -> algorithm, result -> precision,
+                            result -> threads, result -> median, result -> min, result -> max, result -> stddev,
+                            result -> decimals);
+                fflush(stdout);
+                num_results++;
+            }
+        }
+    }
+    printf("\n");
+
+    if (options -> csv_file != NULL) write_csv(options -> csv_file, results, num_results, options, cpu);
+    if (options -> json_file != NULL) write_json(options -> json_file, results, num_results, options, cpu);
+    slower = 0;
+    if (options -> baseline_file != NULL) slower = compare_baseline(options, results, num_results, cpu);
+
+    //Clear memory
+    free(results);
+    free(times);
+
+    return slower;
+}
@@ -0,0 +1,27 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../Headers/Benchmark/Benchmark.h"
+#include "../../Headers/Common/Print_title.h"
+
+
+int main(int argc, char **argv){
+    struct benchmark_options options;
+
+    //Print title
+    print_PiDecimals_title();
+    printf("  Benchmark! \n");
+    printf("\n");
+
+    if (parse_benchmark_options(argc, argv, &options) != 0){
+        printf("  Params are not correct. Try with:\n");
+        printf("    %s [options] \n", argv[0]);
+        print_benchmark_usage();
+        printf("\n");
+        exit(-1);
+    }
+
+    //Fails if any case is slower than the baseline or cannot be compared (or it could not be read)
+    if (run_benchmark(&options) != 0) exit(1);
+
+    exit(0);
+}
@@ -0,0 +1,340 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <unistd.h>
+#include "../../Headers/Benchmark/Benchmark.h"
+#include "../../Headers/Benchmark/Regression.h"
+
+#define MAX_FIELDS 32
+#define BASELINES_DIRECTORY "Resources/Baselines/"
+
+
+/************************************************************************************
+ * Regression gate (--baseline file|auto, --tolerance, --significance)              *
+ * The baseline is the CSV of a previous benchmark (--csv), which has the times of  *
+ * every repetition. With auto, it is the baseline of this processor in             *
+ * Resources/Baselines/<model>.csv, with the model in lowercase and every other     *
+ * character as '-' (see README). Each case of the run is compared with the same    *
+ * algorithm, precision and threads of the baseline:                                *
+ *   - Change: current median / baseline median - 1                                 *
+ *   - Interval: 95% bootstrap confidence interval of that ratio of medians         *
+ *   - p-value: one-sided Mann-Whitney test of the current times being slower       *
+ *     (exact without ties, or with the normal approximation)                       *
+ * A case is slower when its change is higher than the tolerance and its p-value is *
+ * lower than the significance, so the noise of the repetitions does not fail the   *
+ * gate. The benchmark exits with an error if any case is slower, is not in the     *
+ * baseline or has too few repetitions to reach the significance, so the gate never *
+ * passes without comparing every case.                                             *
+ *                                                                                  *
+ ************************************************************************************/
+
+
+/*
+ * Splits a CSV line in its fields (in place). The fields can be quoted, without quotes inside.
+ * It returns the number of fields.
+ */
+int split_csv(char * line, char ** fields){
+    int num_fields;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    num_fields = 0;
+    while(num_fields < MAX_FIELDS){
+        if (*line == '"'){
+            fields[num_fields++] = ++line;
+            line = strchr(line, '"');
+            if (line == NULL) break;
+            *line++ = '\0';
+        } else {
+            fields[num_fields++] = line;
+            line += strcspn(line, ",");
+        }
+        if (*line != ',') break;
+        *line++ = '\0';
+    }
+    return num_fields;
+}
+
+int find_column(char ** fields, int num_fields, char * name){
+    int i;
+
+    for(i = 0; i < num_fields; i++){
+        if (strcmp(fields[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+/*
+ * Reads the cases of a benchmark CSV with their times.
+ * It returns 0, or -1 if the file could not be read or does not have the times.
+ */
+int read_baseline(char * file_name, struct baseline * baseline){
+    int num_fields, algorithm, precision, threads, revision, cpu, processors, times, capacity;
+    char * line, * fields[MAX_FIELDS], * value, * end;
+    size_t size;
+    FILE * file;
+    struct baseline_case * bcase;
+
+    memset(baseline, 0, sizeof(struct baseline));
+    file = fopen(file_name, "r");
+    if (file == NULL) return -1;
+
+    line = NULL;
+    size = 0;
+    if (getline(&line, &size, file) < 0){
+        fclose(file);
+        return -1;
+    }
+    num_fields = split_csv(line, fields);
+    revision = find_column(fields, num_fields, "revision");
+    cpu = find_column(fields, num_fields, "cpu");
+    processors = find_column(fields, num_fields, "processors");
+    algorithm = find_column(fields, num_fields, "algorithm");
+    precision = find_column(fields, num_fields, "precision");
+    threads = find_column(fields, num_fields, "threads");
+    times = find_column(fields, num_fields, "times");
+    if (algorithm < 0 || precision < 0 || threads < 0 || times < 0){
+        free(line);
+        fclose(file);
+        return -1;
+    }
+
+    capacity = 0;
+    while(getline(&line, &size, file) >= 0){
+        num_fields = split_csv(line, fields);
+        if (num_fields <= times) continue;
+        if (baseline -> num_cases == capacity){
+            capacity = 2 * capacity + 16;
+            baseline -> cases = realloc(baseline -> cases, sizeof(struct baseline_case) * capacity);
+        }
+        if (baseline -> num_cases == 0){
+            if (revision >= 0) snprintf(baseline -> revision, sizeof(baseline -> revision), "%s", fields[revision]);
+            if (cpu >= 0) snprintf(baseline -> cpu, sizeof(baseline -> cpu), "%s", fields[cpu]);
+            if (processors >= 0) baseline -> processors = atol(fields[processors]);
+        }
+
+        bcase = &baseline -> cases[baseline -> num_cases];
+        bcase -> algorithm = atoi(fields[algorithm]);
+        bcase -> precision = atoi(fields[precision]);
+        bcase -> threads = atoi(fields[threads]);
+        bcase -> num_times = 1;
+        for(value = fields[times]; *value != '\0'; value++) bcase -> num_times += (*value == ';');
+        bcase -> times = malloc(sizeof(double) * bcase -> num_times);
+        bcase -> num_times = 0;
+        for(value = fields[times]; *value != '\0'; value = (*end == ';') ? end + 1 : end){
+            bcase -> times[bcase -> num_times] = strtod(value, &end);
+            if (end == value) break;
+            bcase -> num_times++;
+        }
+        if (bcase -> num_times == 0) free(bcase -> times);
+        else baseline -> num_cases++;
+    }
+
+    free(line);
+    fclose(file);
+    return 0;
+}
+
+void free_baseline(struct baseline * baseline){
+    int i;
+
+    for(i = 0; i < baseline -> num_cases; i++) free(baseline -> cases[i].times);
+    free(baseline -> cases);
+}
+
+/*
+ * One-sided Mann-Whitney test: returns the probability of a U statistic at least as
+ * high as the one of x against y if both samples come from the same distribution,
+ * so a low value means that x tends to be higher (slower) than y.
+ */
+double mann_whitney(double * x, int m, double * y, int n){
+    int i, j, k, total, ties, group;
+    long u_size;
+    double u, mean, variance, tie_sum, count, upper;
+    double * all, * ways;
+
+    u = 0;
+    for(i = 0; i < m; i++){
+        for(j = 0; j < n; j++) u += (x[i] > y[j]) ? 1 : (x[i] == y[j]) ? 0.5 : 0;
+    }
+
+    //Sizes of the groups of equal times
+    total = m + n;
+    all = malloc(sizeof(double) * total);
+    memcpy(all, x, sizeof(double) * m);
+    memcpy(all + m, y, sizeof(double) * n);
+    qsort(all, total, sizeof(double), compare_times);
+    ties = 0;
+    tie_sum = 0;
+    for(i = 0; i < total; i += group){
+        for(group = 1; i + group < total && all[i + group] == all[i]; group++);
+        if (group > 1) ties = 1;
+        tie_sum += (double) group * group * group - group;
+    }
+    free(all);
+
+    if (!ties && (long) m * n <= EXACT_LIMIT){
+        //The numbers of orders with each U are the coefficients of the Gaussian binomial
+        //(m + n choose m), the product of (1 - q^(n + k)) / (1 - q^k) for k = 1..m
+        u_size = (long) m * n + 1;
+        ways = calloc(u_size, sizeof(double));
+        ways[0] = 1;
+        for(k = 1; k <= m; k++){
+            for(i = u_size - 1; i >= n + k; i--) ways[i] -= ways[i - n - k];
+            for(i = k; i < u_size; i++) ways[i] += ways[i - k];
+        }
+        count = 0;
+        upper = 0;
+        for(i = 0; i < u_size; i++){
+            count += ways[i];
+            if (i >= u) upper += ways[i];
+        }
+        free(ways);
+        return upper / count;
+    }
+
+    //Normal approximation, with the correction of the ties and the continuity
+    mean = (double) m * n / 2;
+    variance = (double) m * n / 12 * ((total + 1) - tie_sum / ((double) total * (total - 1)));
+    if (variance <= 0) return 1;
+    return 0.5 * erfc((u - mean - 0.5) / sqrt(2 * variance));
+}
+
+double sample_median(double * times, int num_times){
+    qsort(times, num_times, sizeof(double), compare_times);
+    return (num_times % 2 == 1) ? times[num_times / 2] : (times[num_times / 2 - 1] + times[num_times / 2]) / 2;
+}
+
+/*
+ * Gets the 95% bootstrap confidence interval of median(x) / median(y) in low and high.
+ * The resamples always use the same seed, so the interval of the same times does not change.
+ */
+void bootstrap_ratio(double * x, int m, double * y, int n, double * low, double * high){
+    int b, i;
+    unsigned int seed;
+    double * ratios, * sample;
+
+    ratios = malloc(sizeof(double) * BOOTSTRAP_SAMPLES);
+    sample = malloc(sizeof(double) * ((m > n) ? m : n));
+    seed = 1;
+    for(b = 0; b < BOOTSTRAP_SAMPLES; b++){
+        for(i = 0; i < m; i++) sample[i] = x[rand_r(&seed) % m];
+        ratios[b] = sample_median(sample, m);
+        for(i = 0; i < n; i++) sample[i] = y[rand_r(&seed) % n];
+        ratios[b] /= sample_median(sample, n);
+    }
+    qsort(ratios, BOOTSTRAP_SAMPLES, sizeof(double), compare_times);
+    *low = ratios[(int) (BOOTSTRAP_SAMPLES * 0.025)];
+    *high = ratios[(int) (BOOTSTRAP_SAMPLES * 0.975) - 1];
+
+    //Clear memory
+    free(ratios);
+    free(sample);
+}
+
+/*
+ * Stores in file_name the baseline of the processor: Resources/Baselines/<model>.csv,
+ * with the model in lowercase and the rest of characters replaced by '-' (without repeating it)
+ */
+void get_baseline_name(char * cpu, char * file_name, int size){
+    int length;
+
+    length = snprintf(file_name, size, "%s", BASELINES_DIRECTORY);
+    for(; *cpu != '\0' && length < size - 5; cpu++){
+        if (isalnum((unsigned char) *cpu)) file_name[length++] = tolower((unsigned char) *cpu);
+        else if (file_name[length - 1] != '-' && file_name[length - 1] != '/') file_name[length++] = '-';
+    }
+    if (file_name[length - 1] == '-') length--;
+    snprintf(file_name + length, size - length, ".csv");
+}
+
+/*
+ * Compares the results with the baseline of the options and prints the change of every case.
+ * It returns the number of cases that fail the gate (slower, not in the baseline or with too few
+ * repetitions), 1 if there are no cases, or -1 if the baseline could not be read.
+ */
+int compare_baseline(struct benchmark_options * options, struct benchmark_result * results, int num_results, char * cpu){
+    int i, c, slower, missing, inconclusive;
+    double baseline_median, change, low, high, p_slower, p_faster, smallest_p;
+    char * verdict, * file_name, machine_file[512];
+    struct baseline baseline;
+    struct baseline_case * bcase;
+    struct benchmark_result * result;
+
+    file_name = options -> baseline_file;
+    if (strcmp(file_name, "auto") == 0){
+        get_baseline_name(cpu, machine_file, sizeof(machine_file));
+        file_name = machine_file;
+    }
+    if (read_baseline(file_name, &baseline) != 0){
+        printf("  Baseline %s could not be read (it must be the CSV of a benchmark) \n\n", file_name);
+        return -1;
+    }
+    printf("  Baseline: %s (revision %s) \n", file_name, baseline.revision);
+    if (strcmp(baseline.cpu, cpu) != 0 || baseline.processors != sysconf(_SC_NPROCESSORS_ONLN)){
+        printf("  WARNING: the baseline was measured in another machine (%s, %ld online) \n",
+                    baseline.cpu, baseline.processors);
+    }
+    printf("  Tolerance: %.1f%%, significance: %g \n", options -> tolerance, options -> significance);
+    printf("\n");
+    printf("  %-9s %-9s %-7s %-10s %-10s %-9s %-19s %-9s %-7s \n", "Algorithm", "Precision", "Threads",
+                "Baseline", "Current", "Change", "Interval (95%)", "p-value", "Result");
+
+    slower = 0;
+    missing = 0;
+    inconclusive = 0;
+    for(i = 0; i < num_results; i++){
+        result = &results[i];
+        bcase = NULL;
+        for(c = 0; c < baseline.num_cases && bcase == NULL; c++){
+            if (baseline.cases[c].algorithm == result -> algorithm && baseline.cases[c].precision == result -> precision &&
+                    baseline.cases[c].threads == result -> threads) bcase = &baseline.cases[c];
+        }
+        if (bcase == NULL){
+            printf("  %-9d %-9d %-7d MISSING (not in the baseline) \n", result -> algorithm, result -> precision, result -> threads);
+            missing++;
+            continue;
+        }
+
+        baseline_median = sample_median(bcase -> times, bcase -> num_times);
+        change = result -> median / baseline_median - 1;
+        bootstrap_ratio(result -> times, options -> repetitions, bcase -> times, bcase -> num_times, &low, &high);
+        p_slower = mann_whitney(result -> times, options -> repetitions, bcase -> times, bcase -> num_times);
+        p_faster = mann_whitney(bcase -> times, bcase -> num_times, result -> times, options -> repetitions);
+
+        //Lowest p-value of the exact test with these sizes: 1 / (m + n choose m)
+        smallest_p = 1;
+        for(c = 1; c <= options -> repetitions; c++) smallest_p *= (double) c / (bcase -> num_times + c);
+
+        if (100 * change > options -> tolerance && p_slower < options -> significance){
+            verdict = "SLOWER";
+            slower++;
+        } else if (100 * change < -options -> tolerance && p_faster < options -> significance){
+            verdict = "faster";
+        } else if (smallest_p >= options -> significance){
+            verdict = "TOO FEW REPETITIONS";
+            inconclusive++;
+        } else {
+            verdict = "ok";
+        }
+        printf("  %-9d %-9d %-7d %-10f %-10f %+7.1f%%  [%+6.1f%%, %+6.1f%%]  %-9.4f %s \n", result -> algorithm,
+                    result -> precision, result -> threads, baseline_median, result -> median, 100 * change,
+                    100 * (low - 1), 100 * (high - 1), p_slower, verdict);
+    }
+    printf("\n");
+    if (slower > 0) printf("  REGRESSION: %d cases are significantly slower than the baseline \n", slower);
+    if (missing > 0) printf("  FAILED: %d cases are not in the baseline (regenerate it, see README) \n", missing);
+    if (inconclusive > 0){
+        printf("  FAILED: %d cases cannot reach the significance with %d repetitions (use more with --repetitions) \n",
+                    inconclusive, options -> repetitions);
+    }
+    if (num_results == 0) printf("  FAILED: no case was compared with the baseline \n");
+    if (slower + missing + inconclusive == 0 && num_results > 0) printf("  No case is significantly slower than the baseline \n");
+    printf("\n");
+
+    //Clear memory
+    free_baseline(&baseline);
+
+    return (num_results > 0) ? slower + missing + inconclusive : 1;
+}
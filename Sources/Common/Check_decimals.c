@@ -1,34 +1,302 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <gmp.h>
 #include <omp.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/Common/Check_decimals.h"
+#include "../../Headers/Common/Conversion.h"
+#include "../../Headers/Common/Packed.h"
+#include "../../Headers/Common/Pipeline.h"
+#include "../../Headers/Common/Reference.h"
+#include "../../Headers/Common/Timers.h"
 
+#define COMPARE_BLOCK 64                    // Bytes compared in each SIMD step
+#define COMPARE_SLICE (1 << 16)             // Bytes between the checks of an earlier mismatch
+#define THREAD_BYTES (1 << 20)              // Minimum bytes compared by each thread
+#define PACKED_COMPARE_WORDS 4096           // Words of a packed file converted for each comparison
 
-int check_decimals(mpf_t pi){
-    //Cast the number we want to check to string
-    int bytes_of_pi = ((pi -> _mp_prec + 1) * sizeof(mp_limb_t)) * sizeof(int); 
-    char calculated_pi[bytes_of_pi]; 
-    gmp_sprintf(calculated_pi, "%.Ff", pi);
-
-    //Read the correct pi number from numeroPiCorrecto.txt file and compares the decimals to calculated pi
-    FILE * file;
-    file = fopen("Resources/numeroPiCorrecto.txt", "r");
-    if(file == NULL){
+
+/************************************************************************************
+ * Check of the decimals                                                            *
+ * Resources/numeroPiCorrecto.txt is mapped in memory once, and the computed digits *
+ * are compared with it in blocks of COMPARE_BLOCK bytes (AVX2 or SSE2 byte         *
+ * compares, or 64-bit words without SIMD). Big comparisons are split between       *
+ * threads: each thread checks in every slice if another one already found an       *
+ * earlier mismatch, so the search stops at the first one.                          *
+ *                                                                                  *
+ * The first mismatch is saved with the digits around it and can be shown after     *
+ * the result with print_mismatch. With --reference, the digits are checked with    *
+ * the hashes of a reference store instead (see Reference).                         *
+ *                                                                                  *
+ ************************************************************************************/
+
+struct compare_task {
+    char * computed;
+    char * correct;
+    long begin;
+    long end;
+    long * first;                           // First mismatch found by any thread
+};
+
+char * check_correct_pi = NULL;             // Mapped numeroPiCorrecto.txt
+long check_correct_size = 0;                // Characters without the end of line
+long check_mismatch = -1;                   // Character of the first mismatch (-1 = none)
+long check_window_start = 0;
+char check_computed_window[2 * DIFF_WINDOW + 2];
+char check_correct_window[2 * DIFF_WINDOW + 2];
+
+
+/*
+ * Maps the correct pi number in memory (only the first time)
+ */
+void map_correct_pi(){
+    int fd;
+    struct stat file_stat;
+
+    if (check_correct_pi != NULL) return;
+    fd = open("Resources/numeroPiCorrecto.txt", O_RDONLY);
+    if (fd < 0 || fstat(fd, &file_stat) != 0 || file_stat.st_size == 0 ||
+            (check_correct_pi = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
         printf("numeroPiCorrecto.txt not found \n");
         exit(-1);
-    } 
+    }
+    close(fd);
+    madvise(check_correct_pi, file_stat.st_size, MADV_SEQUENTIAL);
+    check_correct_size = file_stat.st_size;
+    while(check_correct_size > 0 && (check_correct_pi[check_correct_size - 1] == '\n' ||
+                                        check_correct_pi[check_correct_size - 1] == '\r')){
+        check_correct_size--;
+    }
+}
 
-    char correct_pi_char;
-    int i = 0;
-    while((correct_pi_char = fgetc(file)) != EOF){
-        if( (i >= bytes_of_pi) || (correct_pi_char != calculated_pi[i])){
-            break;
-        }
-        i++;
+/*
+ * Returns the first different byte of two blocks of COMPARE_BLOCK bytes, or COMPARE_BLOCK
+ */
+int block_mismatch(char * a, char * b){
+#if defined(__AVX2__) || defined(__SSE2__)
+    uint64_t equal;
+
+#if defined(__AVX2__)
+    equal = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *) a),
+                                                                _mm256_loadu_si256((__m256i *) b)));
+    equal |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *) (a + 32)),
+                                                                _mm256_loadu_si256((__m256i *) (b + 32)))) << 32;
+#else
+    int i;
+
+    equal = 0;
+    for(i = 0; i < COMPARE_BLOCK; i += 16){
+        equal |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *) (a + i)),
+                                                                _mm_loadu_si128((__m128i *) (b + i)))) << i;
     }
-    i = (i < 2) ? 0: i - 2;
-    
-    fclose(file);
+#endif
+    return (equal == ~0UL) ? COMPARE_BLOCK : __builtin_ctzll(~equal);
+#else
+    int i;
+    uint64_t x, y;
 
+    for(i = 0; i < COMPARE_BLOCK; i += 8){
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        if (x != y) break;
+    }
+    while(i < COMPARE_BLOCK && a[i] == b[i]) i++;
     return i;
+#endif
+}
+
+void * compare_slices(void * arg){
+    long position, slice_end, found, first;
+    int offset;
+    struct compare_task * task;
+
+    task = (struct compare_task *) arg;
+    for(position = task -> begin; position < task -> end; position = slice_end){
+        //An earlier mismatch was already found by another thread
+        if (__atomic_load_n(task -> first, __ATOMIC_ACQUIRE) < position) return NULL;
+        slice_end = (position + COMPARE_SLICE < task -> end) ? position + COMPARE_SLICE : task -> end;
+        for(found = position; found + COMPARE_BLOCK <= slice_end; found += COMPARE_BLOCK){
+            offset = block_mismatch(task -> computed + found, task -> correct + found);
+            if (offset < COMPARE_BLOCK){
+                found += offset;
+                break;
+            }
+        }
+        if (found + COMPARE_BLOCK > slice_end){
+            while(found < slice_end && task -> computed[found] == task -> correct[found]) found++;
+        }
+        if (found < slice_end){
+            first = __atomic_load_n(task -> first, __ATOMIC_RELAXED);
+            while(found < first && !__atomic_compare_exchange_n(task -> first, &first, found, 0,
+                                                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Returns the position of the first different character of computed and correct,
+ * or length if they are equal, comparing with up to num_threads threads.
+ */
+long first_mismatch(char * computed, char * correct, long length, int num_threads){
+    int thread, created;
+    long first, part;
+    pthread_t * threads;
+    struct compare_task * tasks;
+
+    first = length;
+    if (num_threads > length / THREAD_BYTES) num_threads = length / THREAD_BYTES;
+    if (num_threads < 1) num_threads = 1;
+    threads = malloc(sizeof(pthread_t) * num_threads);
+    tasks = malloc(sizeof(struct compare_task) * num_threads);
+    part = length / num_threads;
+    for(thread = 0; thread < num_threads; thread++){
+        tasks[thread].computed = computed;
+        tasks[thread].correct = correct;
+        tasks[thread].begin = thread * part;
+        tasks[thread].end = (thread == num_threads - 1) ? length : (thread + 1) * part;
+        tasks[thread].first = &first;
+    }
+
+    //The first part is compared by the caller
+    created = 1;
+    while(created < num_threads && pthread_create(&threads[created], NULL, compare_slices, &tasks[created]) == 0) created++;
+    compare_slices(&tasks[0]);
+    for(thread = created; thread < num_threads; thread++) compare_slices(&tasks[thread]);
+    for(thread = 1; thread < created; thread++) pthread_join(threads[thread], NULL);
+
+    free(threads);
+    free(tasks);
+    return first;
+}
+
+/*
+ * Returns the characters of the correct pi number ("3." and the decimals),
+ * from Resources/numeroPiCorrecto.txt or the reference store of the options (see Reference)
+ */
+long correct_pi_length(){
+    if (run_options.reference_file != NULL) return reference_length();
+    map_correct_pi();
+    return check_correct_size;
+}
+
+/*
+ * Compares the length characters of computed with the correct pi number from the
+ * character position ("3." are the characters 0 and 1). It returns the number of
+ * characters that match; the first mismatch is saved to be shown by print_mismatch.
+ */
+long compare_correct_pi(char * computed, long length, long position){
+    long matched, available, start, end;
+    double start_time;
+
+    start_time = phase_clock();
+    if (position == 0) check_mismatch = -1;
+    available = correct_pi_length();
+    if (position >= available){
+        phase_add(PHASE_CHECK, start_time);
+        return 0;
+    }
+    if (length > available - position) length = available - position;
+
+    if (run_options.reference_file != NULL) matched = compare_reference(computed, length, position);
+    else matched = first_mismatch(computed, check_correct_pi + position, length, sysconf(_SC_NPROCESSORS_ONLN));
+    if (matched < length && check_mismatch < 0){
+        check_mismatch = position + matched;
+        start = (matched > DIFF_WINDOW) ? matched - DIFF_WINDOW : 0;
+        end = (matched + DIFF_WINDOW + 1 < length) ? matched + DIFF_WINDOW + 1 : length;
+        memcpy(check_computed_window, computed + start, end - start);
+        check_computed_window[end - start] = '\0';
+        check_window_start = position + start;
+
+        end = (check_mismatch + DIFF_WINDOW + 1 < available) ? check_mismatch + DIFF_WINDOW + 1 : available;
+        if (run_options.reference_file != NULL) end = check_window_start + read_reference(check_window_start, end - check_window_start, check_correct_window);
+        else memcpy(check_correct_window, check_correct_pi + check_window_start, end - check_window_start);
+        check_correct_window[end - check_window_start] = '\0';
+    }
+    phase_add(PHASE_CHECK, start_time);
+    return matched;
+}
+
+/*
+ * Shows the first mismatch of the last check, with the characters around it
+ */
+void print_mismatch(){
+    if (check_mismatch < 0) return;
+    printf("  First mismatch at decimal %ld (character %ld): \n", check_mismatch - 1, check_mismatch);
+    printf("      Computed: ...%s \n", check_computed_window);
+    printf("      Correct:  ...%s \n", check_correct_window);
+    printf("                   %*s^ \n", (int) (check_mismatch - check_window_start), "");
+}
+
+/*
+ * Compares the string of the calculated pi ("3.1415...") with the correct pi number
+ * and returns the number of decimals that match.
+ */
+int check_decimals_string(char * calculated_pi, long bytes_of_pi){
+    long i;
+
+    i = compare_correct_pi(calculated_pi, bytes_of_pi, 0);
+    return (i < 2) ? 0 : i - 2;
+}
+
+/*
+ * Converts pi and compares it with the correct pi number at the same time (see Pipeline)
+ */
+int check_decimals(mpf_t pi){
+    return pipeline_check_decimals(pi, NULL, 0, 0);
+}
+
+/*
+ * Compares the digits of a packed file (see Packed) with the correct pi number,
+ * reading them in place (mmap). It returns the number of decimals that match.
+ */
+int check_decimals_packed(char * file_name){
+    long word, words, i, block, matched, length, piece;
+    char int_string[24], * digits;
+    struct packed_file packed;
+
+    if (open_packed(file_name, &packed) != 0){
+        printf("  %s is not a packed file \n", file_name);
+        return 0;
+    }
+    block = verify_packed(&packed);
+    if (packed.header -> base != 10 || block >= 0){
+        if (block >= 0) printf("  Block %ld of %s is corrupted \n", block, file_name);
+        else printf("  %s does not have decimal digits \n", file_name);
+        close_packed(&packed);
+        return 0;
+    }
+
+    //Integer part and point, then the digits of the words by pieces of PACKED_COMPARE_WORDS words
+    matched = 0;
+    length = sprintf(int_string, "%lu.", (unsigned long) packed.header -> int_part);
+    if (compare_correct_pi(int_string, length, 0) == length){
+        digits = malloc(PACKED_COMPARE_WORDS * 19);
+        for(word = 0; word < (long) packed.header -> num_words; word += PACKED_COMPARE_WORDS){
+            words = (long) packed.header -> num_words - word;
+            if (words > PACKED_COMPARE_WORDS) words = PACKED_COMPARE_WORDS;
+            for(i = 0; i < words; i++) word_to_digits(digits + i * 19, packed.words[word + i]);
+            length = words * 19;
+            if (length > (long) packed.header -> num_digits - matched) length = packed.header -> num_digits - matched;
+            piece = compare_correct_pi(digits, length, matched + strlen(int_string));
+            matched += piece;
+            if (piece < length) break;
+        }
+        free(digits);
+    }
+
+    close_packed(&packed);
+
+    return matched;
 }
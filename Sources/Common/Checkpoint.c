@@ -0,0 +1,432 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/Common/Checkpoint.h"
+
+
+/************************************************************************************
+ * Checkpoints of long runs (--checkpoint file, --checkpoint-interval seconds)      *
+ * Each thread works on a progression of iterations (first, first + stride, ...     *
+ * before end), so its state is a slot with the progression, the next iteration    *
+ * and the values it needs to go on (its partial sum and the dependencies).         *
+ *                                                                                  *
+ * Every interval a writer thread asks the threads for their state. Each thread     *
+ * copies its values into its slot when it sees the request between two            *
+ * iterations, so the loops never wait for the disk. When all the slots are         *
+ * published, the writer saves them in file.tmp and renames it to file, so the      *
+ * file always has the last consistent checkpoint.                                  *
+ *                                                                                  *
+ ************************************************************************************
+ * File format (binary, native byte order):                                         *
+ *   Header: struct checkpoint_header                                  (int)        *
+ *   Slot:   first, stride, next, end                                  (int)        *
+ *           values: size (int), exponent (long), abs(size) limbs                   *
+ *                                                                                  *
+ ************************************************************************************/
+
+int checkpoint_enabled = 0, checkpoint_resumed = 0;
+int checkpoint_generation, checkpoint_stop;
+int checkpoint_num_slots, checkpoint_max_slots, checkpoint_required_slots;
+char * checkpoint_file_name;
+struct checkpoint_header checkpoint_properties;
+struct checkpoint_slot * checkpoint_slots;
+pthread_t checkpoint_writer_thread;
+pthread_mutex_t checkpoint_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t checkpoint_published = PTHREAD_COND_INITIALIZER;
+pthread_cond_t checkpoint_wakeup = PTHREAD_COND_INITIALIZER;
+
+
+void write_mpf(FILE * file, mpf_t value){
+    int size;
+    long exp;
+
+    size = value -> _mp_size;
+    exp = value -> _mp_exp;
+    fwrite(&size, sizeof(int), 1, file);
+    fwrite(&exp, sizeof(long), 1, file);
+    fwrite(value -> _mp_d, sizeof(mp_limb_t), (size >= 0) ? size : -size, file);
+}
+
+/*
+ * The precision of value is kept. If the stored value has more limbs than value
+ * can store, only the most significant ones are read.
+ */
+int read_mpf(FILE * file, mpf_t value){
+    int size, limbs, skipped;
+    long exp;
+    mp_limb_t * buffer;
+
+    if (fread(&size, sizeof(int), 1, file) != 1) return -1;
+    if (fread(&exp, sizeof(long), 1, file) != 1) return -1;
+    limbs = (size >= 0) ? size : -size;
+    buffer = malloc(sizeof(mp_limb_t) * (limbs + 1));
+    if (fread(buffer, sizeof(mp_limb_t), limbs, file) != (size_t) limbs){
+        free(buffer);
+        return -1;
+    }
+
+    skipped = (limbs > value -> _mp_prec + 1) ? limbs - (value -> _mp_prec + 1) : 0;
+    memcpy(value -> _mp_d, buffer + skipped, sizeof(mp_limb_t) * (limbs - skipped));
+    value -> _mp_size = (size >= 0) ? limbs - skipped : skipped - limbs;
+    value -> _mp_exp = exp;
+    free(buffer);
+    return 0;
+}
+
+/*
+ * Saves the open slots in a temporary file, which replaces the checkpoint
+ * once it is completely on disk.
+ * IMPORTANT: The slots should not be modified meanwhile
+ */
+void write_checkpoint_file(){
+    int slot, v;
+    char * temp_name;
+    FILE * file;
+    struct checkpoint_slot * current;
+
+    temp_name = malloc(strlen(checkpoint_file_name) + 5);
+    sprintf(temp_name, "%s.tmp", checkpoint_file_name);
+    file = fopen(temp_name, "wb");
+    if(file == NULL){
+        printf("  Checkpoint %s could not be written \n", temp_name);
+        free(temp_name);
+        return;
+    }
+
+    checkpoint_properties.slots = checkpoint_num_slots;
+    fwrite(&checkpoint_properties, sizeof(struct checkpoint_header), 1, file);
+    for(slot = 0; slot < checkpoint_num_slots; slot++){
+        current = &checkpoint_slots[slot];
+        fwrite(&current -> first, sizeof(int), 1, file);
+        fwrite(&current -> stride, sizeof(int), 1, file);
+        fwrite(&current -> next, sizeof(int), 1, file);
+        fwrite(&current -> end, sizeof(int), 1, file);
+        for(v = 0; v < checkpoint_properties.values; v++){
+            write_mpf(file, current -> values[v]);
+        }
+    }
+
+    fflush(file);
+    fsync(fileno(file));
+    if (ferror(file) || fclose(file) != 0 || rename(temp_name, checkpoint_file_name) != 0){
+        printf("  Checkpoint %s could not be written \n", checkpoint_file_name);
+    }
+    free(temp_name);
+}
+
+/*
+ * Loads a checkpoint file: its header and its slots (allocated here, see clear_checkpoint_slots).
+ * It returns -1 if the file does not exist, and exits if it is corrupted.
+ */
+int read_checkpoint(char * file_name, struct checkpoint_header * header, struct checkpoint_slot ** slots){
+    int slot, v, error;
+    FILE * file;
+    struct checkpoint_slot * current;
+
+    file = fopen(file_name, "rb");
+    if(file == NULL) return -1;
+
+    error = fread(header, sizeof(struct checkpoint_header), 1, file) != 1 ||
+                header -> magic != CHECKPOINT_MAGIC || header -> version != CHECKPOINT_VERSION;
+    *slots = NULL;
+    if (!error){
+        *slots = malloc(sizeof(struct checkpoint_slot) * (header -> slots + 1));
+        for(slot = 0; slot < header -> slots; slot++){
+            current = &(*slots)[slot];
+            current -> done = 0;
+            current -> idle = 0;
+            current -> generation = 0;
+            current -> values = malloc(sizeof(mpf_t) * header -> values);
+            for(v = 0; v < header -> values; v++) mpf_init(current -> values[v]);
+        }
+    }
+    for(slot = 0; !error && slot < header -> slots; slot++){
+        current = &(*slots)[slot];
+        error = fread(&current -> first, sizeof(int), 1, file) != 1 || fread(&current -> stride, sizeof(int), 1, file) != 1 ||
+                    fread(&current -> next, sizeof(int), 1, file) != 1 || fread(&current -> end, sizeof(int), 1, file) != 1;
+        for(v = 0; !error && v < header -> values; v++){
+            error = read_mpf(file, current -> values[v]) != 0;
+        }
+    }
+    fclose(file);
+
+    if (error){
+        printf("  Checkpoint %s is corrupted \n\n", file_name);
+        exit(-1);
+    }
+    return 0;
+}
+
+void clear_checkpoint_slots(struct checkpoint_slot * slots, int num_slots, int num_values){
+    int slot, v;
+
+    for(slot = 0; slot < num_slots; slot++){
+        for(v = 0; v < num_values; v++) mpf_clear(slots[slot].values[v]);
+        free(slots[slot].values);
+    }
+    free(slots);
+}
+
+/*
+ * Writer thread: every interval it asks the threads for their state, waits until
+ * every open slot is published (or finished or idle) and saves them.
+ * Nothing is saved until the required slots are open, so the checkpoint always
+ * has a slot for every thread.
+ */
+void * checkpoint_writer(void * arg){
+    int slot, pending;
+    struct timespec deadline;
+
+    (void) arg;
+    pthread_mutex_lock(&checkpoint_mutex);
+    while(!checkpoint_stop){
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += run_options.checkpoint_interval;
+        while(!checkpoint_stop &&
+                    pthread_cond_timedwait(&checkpoint_wakeup, &checkpoint_mutex, &deadline) != ETIMEDOUT);
+        if (checkpoint_stop) break;
+        if (checkpoint_num_slots < checkpoint_required_slots) continue;
+
+        __atomic_store_n(&checkpoint_generation, checkpoint_generation + 1, __ATOMIC_RELEASE);
+        do {
+            pending = 0;
+            for(slot = 0; slot < checkpoint_num_slots; slot++){
+                if (!checkpoint_slots[slot].done && !checkpoint_slots[slot].idle &&
+                            checkpoint_slots[slot].generation != checkpoint_generation) pending = 1;
+            }
+            if (pending) pthread_cond_wait(&checkpoint_published, &checkpoint_mutex);
+        } while(pending && !checkpoint_stop);
+        if (checkpoint_stop) break;
+
+        write_checkpoint_file();
+    }
+    pthread_mutex_unlock(&checkpoint_mutex);
+
+    return NULL;
+}
+
+/*
+ * Prepares up to max_slots slots of num_values values, saved in file_name
+ * with the properties of the run, and starts the writer, which waits until
+ * required_slots slots are open to save them.
+ */
+void init_checkpoint_file(char * file_name, int algorithm, int num_iterations, int max_slots,
+                            int required_slots, int num_values, int num_procs, int generation){
+    checkpoint_file_name = file_name;
+    checkpoint_properties.magic = CHECKPOINT_MAGIC;
+    checkpoint_properties.version = CHECKPOINT_VERSION;
+    checkpoint_properties.algorithm = algorithm;
+    checkpoint_properties.precision = mpf_get_default_prec();
+    checkpoint_properties.iterations = num_iterations;
+    checkpoint_properties.processes = num_procs;
+    checkpoint_properties.generation = generation;
+    checkpoint_properties.slots = 0;
+    checkpoint_properties.values = num_values;
+
+    checkpoint_num_slots = 0;
+    checkpoint_max_slots = max_slots;
+    checkpoint_required_slots = required_slots;
+    checkpoint_slots = malloc(sizeof(struct checkpoint_slot) * max_slots);
+
+    checkpoint_resumed = 0;
+    checkpoint_generation = 0;
+    checkpoint_stop = 0;
+    checkpoint_enabled = 1;
+    pthread_create(&checkpoint_writer_thread, NULL, checkpoint_writer, NULL);
+}
+
+/*
+ * Only BBP and Chudnovsky (last versions) save checkpoints in the Sequential and OMP
+ * versions, so the other algorithms exit if --checkpoint or --resume are given.
+ */
+void check_checkpoint_options(){
+    if (run_options.checkpoint_file != NULL || run_options.resume){
+        printf("  --checkpoint and --resume can only be used with BBP and Chudnovsky (last versions) \n\n");
+        exit(-1);
+    }
+}
+
+/*
+ * Checkpoints of the Sequential and OMP algorithms: one slot per thread.
+ * With --resume, the slots are loaded from the checkpoint file, which must be
+ * written with the same properties and number of threads.
+ * It does nothing if no checkpoint file is given.
+ */
+void init_checkpoint(int algorithm, int num_iterations, int num_slots, int num_values){
+    struct checkpoint_header header;
+    struct checkpoint_slot * slots;
+
+    if (run_options.checkpoint_file == NULL) return;
+
+    init_checkpoint_file(run_options.checkpoint_file, algorithm, num_iterations, num_slots, num_slots, num_values, 1, 0);
+    if (!run_options.resume) return;
+
+    if (read_checkpoint(run_options.checkpoint_file, &header, &slots) != 0){
+        printf("  Checkpoint %s not found, starting from the first iteration \n", run_options.checkpoint_file);
+        return;
+    }
+    if (header.algorithm != algorithm || header.precision != (int) mpf_get_default_prec() || header.iterations != num_iterations ||
+                header.slots != num_slots || header.values != num_values){
+        printf("  Checkpoint %s was written with other algorithm, precision or number of threads (%d) \n\n",
+                    run_options.checkpoint_file, header.slots);
+        exit(-1);
+    }
+    printf("  Resuming from checkpoint %s \n", run_options.checkpoint_file);
+
+    pthread_mutex_lock(&checkpoint_mutex);
+    free(checkpoint_slots);
+    checkpoint_slots = slots;
+    checkpoint_num_slots = num_slots;
+    checkpoint_resumed = 1;
+    pthread_mutex_unlock(&checkpoint_mutex);
+}
+
+/*
+ * Opens a slot for the progression of a thread with its initial values (zeros if values is NULL).
+ * It returns the slot, or -1 if there are no checkpoints.
+ */
+int open_checkpoint_slot(int first, int stride, int next, int end, mpf_ptr * values){
+    int slot, v;
+    struct checkpoint_slot * current;
+
+    if (!checkpoint_enabled) return -1;
+
+    pthread_mutex_lock(&checkpoint_mutex);
+    if (checkpoint_num_slots == checkpoint_max_slots){
+        pthread_mutex_unlock(&checkpoint_mutex);
+        return -1;
+    }
+    slot = checkpoint_num_slots;
+    current = &checkpoint_slots[slot];
+    current -> first = first;
+    current -> stride = stride;
+    current -> next = next;
+    current -> end = end;
+    current -> done = 0;
+    current -> idle = 0;
+    current -> generation = 0;
+    current -> values = malloc(sizeof(mpf_t) * checkpoint_properties.values);
+    for(v = 0; v < checkpoint_properties.values; v++){
+        mpf_init(current -> values[v]);
+        if (values != NULL) mpf_set(current -> values[v], values[v]);
+    }
+    checkpoint_num_slots++;
+    pthread_mutex_unlock(&checkpoint_mutex);
+
+    return slot;
+}
+
+/*
+ * Sets the state of a thread from the slot of the resumed checkpoint that starts at first.
+ * It returns the slot, or -1 if the run is not resumed, so the thread must start as usual.
+ */
+int resume_checkpoint(int first, int * next, int * end, mpf_ptr * values){
+    int slot, v;
+
+    if (!checkpoint_resumed) return -1;
+
+    for(slot = 0; slot < checkpoint_num_slots; slot++){
+        if (checkpoint_slots[slot].first != first) continue;
+        *next = checkpoint_slots[slot].next;
+        *end = checkpoint_slots[slot].end;
+        for(v = 0; v < checkpoint_properties.values; v++){
+            mpf_set(values[v], checkpoint_slots[slot].values[v]);
+        }
+        return slot;
+    }
+    return -1;
+}
+
+/*
+ * Called by each thread between two iterations. It only copies its state
+ * when the writer asks for it, so it costs a comparison otherwise.
+ */
+void checkpoint_poll(int slot, int next, mpf_ptr * values){
+    int v, generation;
+
+    if (slot < 0) return;
+    generation = __atomic_load_n(&checkpoint_generation, __ATOMIC_ACQUIRE);
+    if (checkpoint_slots[slot].generation == generation) return;
+
+    checkpoint_slots[slot].next = next;
+    for(v = 0; v < checkpoint_properties.values; v++){
+        mpf_set(checkpoint_slots[slot].values[v], values[v]);
+    }
+
+    pthread_mutex_lock(&checkpoint_mutex);
+    checkpoint_slots[slot].generation = generation;
+    pthread_cond_broadcast(&checkpoint_published);
+    pthread_mutex_unlock(&checkpoint_mutex);
+}
+
+/*
+ * Called by each thread at the end of its progression with its final values
+ */
+void checkpoint_done(int slot, mpf_ptr * values){
+    int v;
+
+    if (slot < 0) return;
+
+    pthread_mutex_lock(&checkpoint_mutex);
+    checkpoint_slots[slot].next = checkpoint_slots[slot].end;
+    for(v = 0; v < checkpoint_properties.values; v++){
+        mpf_set(checkpoint_slots[slot].values[v], values[v]);
+    }
+    checkpoint_slots[slot].done = 1;
+    pthread_cond_broadcast(&checkpoint_published);
+    pthread_mutex_unlock(&checkpoint_mutex);
+}
+
+/*
+ * Marks a slot as idle while it waits for a thread, so the writer saves its
+ * values without asking for them. It must be set to 0 before the thread starts.
+ */
+void checkpoint_idle(int slot, int idle){
+    if (slot < 0) return;
+
+    pthread_mutex_lock(&checkpoint_mutex);
+    checkpoint_slots[slot].idle = idle;
+    checkpoint_slots[slot].generation = checkpoint_generation;
+    pthread_cond_broadcast(&checkpoint_published);
+    pthread_mutex_unlock(&checkpoint_mutex);
+}
+
+/*
+ * Saves the slots right now, without waiting for the threads
+ * IMPORTANT: No thread should be working on its slot
+ */
+void save_checkpoint(){
+    if (!checkpoint_enabled) return;
+
+    pthread_mutex_lock(&checkpoint_mutex);
+    write_checkpoint_file();
+    pthread_mutex_unlock(&checkpoint_mutex);
+}
+
+/*
+ * Stops the writer and saves the final state of every slot
+ * IMPORTANT: Every thread should have called checkpoint_done
+ */
+void finish_checkpoint(){
+    if (!checkpoint_enabled) return;
+
+    pthread_mutex_lock(&checkpoint_mutex);
+    checkpoint_stop = 1;
+    pthread_cond_broadcast(&checkpoint_wakeup);
+    pthread_cond_broadcast(&checkpoint_published);
+    pthread_mutex_unlock(&checkpoint_mutex);
+    pthread_join(checkpoint_writer_thread, NULL);
+
+    write_checkpoint_file();
+
+    //Clear memory
+    clear_checkpoint_slots(checkpoint_slots, checkpoint_num_slots, checkpoint_properties.values);
+    checkpoint_enabled = 0;
+    checkpoint_resumed = 0;
+}
@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "../../Headers/Common/Timers.h"
+
+#define WORD_DIGITS 19                      // Decimal digits of each 64-bit word (10^19 < 2^64)
+#define WORD_BASE 10000000000000000000UL    // 10^19
+#define LEAF_WORDS 32                       // Words converted directly in each leaf of the recursion
+#define MAX_POWERS 40
+
+
+/************************************************************************************
+ * Binary to decimal conversion                                                     *
+ * The integer is split recursively by the powers 10^(19 * 2^k), so the quotient    *
+ * has the high digits and the remainder has the low digits. The powers are         *
+ * computed once and cached, and the halves are converted by different threads      *
+ * until every thread has a piece (the divisions of GMP are subquadratic).          *
+ *                                                                                  *
+ * The leaves (up to LEAF_WORDS words of 19 digits) are divided by 10^19 to get     *
+ * the words, and each word is turned into ASCII 8 digits at a time, computing the  *
+ * digits of the 8 bytes of a 64-bit word in parallel (SWAR):                       *
+ *      x (8 digits) -> 2 x 4 digits (32-bit lanes) -> 4 x 2 digits (16-bit lanes)  *
+ *                   -> 8 x 1 digit (8-bit lanes) + '0' in every lane               *
+ * The same recursion can store the words themselves (see Packed).                  *
+ *                                                                                  *
+ ************************************************************************************/
+
+struct conversion_task {
+    mpz_ptr value;                          // It is destroyed by the conversion
+    long digits;                            // Digits written, with leading zeros
+    char * out;
+    int threads;                            // Threads available for this piece
+    int words;                              // Words of 19 digits (uint64_t) instead of ASCII
+};
+
+mpz_t conversion_powers[MAX_POWERS];        // conversion_powers[k] = 10^(19 * 2^k)
+int conversion_num_powers = 0;
+
+
+/*
+ * Returns the 8 ASCII digits of x < 10^8 in a 64-bit word, in memory order
+ */
+uint64_t eight_digits(uint32_t x){
+    uint64_t merged, hundreds, pairs, tens;
+
+    merged = (x / 10000) | ((uint64_t) (x % 10000) << 32);            // 32-bit lanes: 4 digits
+    hundreds = ((merged * 10486) >> 20) & 0x0000007F0000007FUL;        // lane / 100
+    pairs = hundreds | ((merged - hundreds * 100) << 16);              // 16-bit lanes: 2 digits
+    tens = ((pairs * 103) >> 10) & 0x000F000F000F000FUL;              // lane / 10
+    pairs = tens | ((pairs - tens * 10) << 8);                         // 8-bit lanes: 1 digit
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    pairs = __builtin_bswap64(pairs);
+#endif
+    return pairs | 0x3030303030303030UL;
+}
+
+/*
+ * Writes the 19 ASCII digits of word < 10^19 in out
+ */
+void word_to_digits(char * out, uint64_t word){
+    uint64_t high, middle, low;
+    char first[8];
+
+    low = eight_digits(word % 100000000);
+    word /= 100000000;
+    middle = eight_digits(word % 100000000);
+    high = eight_digits(word / 100000000);
+
+    memcpy(first, &high, 8);
+    memcpy(out, first + 5, 3);
+    memcpy(out + 3, &middle, 8);
+    memcpy(out + 11, &low, 8);
+}
+
+/*
+ * Converts value < 10^digits by words of 19 digits, from the lowest ones
+ */
+void leaf_to_digits(char * out, mpz_t value, long digits){
+    long position;
+    uint64_t word;
+    char last[WORD_DIGITS];
+
+    position = digits;
+    while(position >= WORD_DIGITS){
+        word = mpz_tdiv_q_ui(value, value, WORD_BASE);
+        position -= WORD_DIGITS;
+        word_to_digits(out + position, word);
+    }
+    if (position > 0){
+        word_to_digits(last, mpz_get_ui(value));
+        memcpy(out, last + WORD_DIGITS - position, position);
+    }
+}
+
+/*
+ * Stores value < 10^digits (digits multiple of 19) as words of 19 digits, the highest first
+ */
+void leaf_to_words(uint64_t * out, mpz_t value, long digits){
+    long word;
+
+    for(word = digits / WORD_DIGITS - 1; word >= 0; word--){
+        out[word] = mpz_tdiv_q_ui(value, value, WORD_BASE);
+    }
+}
+
+/*
+ * Computes the powers 10^(19 * 2^k) needed for numbers of the given digits
+ */
+void cache_powers(long digits){
+    if (conversion_num_powers == 0){
+        mpz_init_set_ui(conversion_powers[0], WORD_BASE);
+        conversion_num_powers = 1;
+    }
+    while(conversion_num_powers < MAX_POWERS &&
+                ((long) WORD_DIGITS << conversion_num_powers) < digits){
+        mpz_init(conversion_powers[conversion_num_powers]);
+        mpz_mul(conversion_powers[conversion_num_powers], conversion_powers[conversion_num_powers - 1],
+                    conversion_powers[conversion_num_powers - 1]);
+        conversion_num_powers++;
+    }
+}
+
+void * convert_task(void * arg){
+    int k;
+    long low_digits;
+    pthread_t thread;
+    mpz_t high;
+    struct conversion_task * task, high_task;
+
+    task = (struct conversion_task *) arg;
+    if (task -> digits <= WORD_DIGITS * LEAF_WORDS){
+        if (task -> words) leaf_to_words((uint64_t *) task -> out, task -> value, task -> digits);
+        else leaf_to_digits(task -> out, task -> value, task -> digits);
+        return NULL;
+    }
+
+    //The low half has the digits of the biggest power below the digits of the piece
+    k = 0;
+    while(k + 1 < conversion_num_powers && ((long) WORD_DIGITS << (k + 1)) < task -> digits) k++;
+    low_digits = (long) WORD_DIGITS << k;
+
+    mpz_init(high);
+    mpz_tdiv_qr(high, task -> value, task -> value, conversion_powers[k]);
+    high_task.value = high;
+    high_task.digits = task -> digits - low_digits;
+    high_task.out = task -> out;
+    high_task.threads = task -> threads / 2;
+    high_task.words = task -> words;
+    task -> digits = low_digits;
+    task -> out += (task -> words) ? high_task.digits / WORD_DIGITS * (long) sizeof(uint64_t) : high_task.digits;
+    task -> threads -= high_task.threads;
+
+    if (high_task.threads > 0 && pthread_create(&thread, NULL, convert_task, &high_task) == 0){
+        convert_task(task);
+        pthread_join(thread, NULL);
+    } else {
+        convert_task(&high_task);
+        convert_task(task);
+    }
+
+    mpz_clear(high);
+    return NULL;
+}
+
+/*
+ * Writes the decimal digits of value < 10^digits in out (exactly digits characters,
+ * with leading zeros) using num_threads threads.
+ * IMPORTANT: value is destroyed
+ */
+void mpz_to_digits(char * out, mpz_t value, long digits, int num_threads){
+    struct conversion_task task;
+
+    if (digits <= 0) return;
+    cache_powers(digits);
+    task.value = value;
+    task.digits = digits;
+    task.out = out;
+    task.threads = (num_threads > 0) ? num_threads : 1;
+    task.words = 0;
+    convert_task(&task);
+}
+
+/*
+ * Stores value < 10^(19 * num_words) in out as num_words words of 19 decimal digits,
+ * the highest first, using num_threads threads.
+ * IMPORTANT: value is destroyed
+ */
+void mpz_to_words(uint64_t * out, mpz_t value, long num_words, int num_threads){
+    struct conversion_task task;
+
+    if (num_words <= 0) return;
+    cache_powers(num_words * WORD_DIGITS);
+    task.value = value;
+    task.digits = num_words * WORD_DIGITS;
+    task.out = (char *) out;
+    task.threads = (num_threads > 0) ? num_threads : 1;
+    task.words = 1;
+    convert_task(&task);
+}
+
+/*
+ * Returns the number of decimals of value that can be accurately represented
+ */
+long get_mpf_decimals(mpf_t value){
+    return (long) (mpf_get_prec(value) * 0.30102999566398);
+}
+
+/*
+ * Returns a new string (in the heap) with the integer part of value and its first
+ * num_decimals decimals ("3.1415..."), truncated. The number of threads is the
+ * number of processors online if num_threads is 0.
+ * IMPORTANT: value should not be negative
+ */
+char * mpf_to_decimal_string(mpf_t value, long num_decimals, int num_threads, long * length){
+    int int_digits;
+    double start;
+    char * str;
+    mpz_t int_part, scaled_int;
+    mpf_t scaled;
+
+    start = phase_clock();
+    if (num_threads <= 0) num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    mpz_inits(int_part, scaled_int, NULL);
+    mpf_init2(scaled, mpf_get_prec(value) + 4 * num_decimals);
+
+    //Digits of the integer part
+    mpz_set_f(int_part, value);
+    int_digits = (mpz_sgn(int_part) == 0) ? 1 : mpz_sizeinbase(int_part, 10);
+    mpz_ui_pow_ui(scaled_int, 10, int_digits - 1);
+    if (int_digits > 1 && mpz_cmp(scaled_int, int_part) > 0) int_digits--;     // mpz_sizeinbase can be one more
+
+    //Scaled value: floor(value * 10^num_decimals)
+    mpz_ui_pow_ui(scaled_int, 10, num_decimals);
+    mpf_set_z(scaled, scaled_int);
+    mpf_mul(scaled, scaled, value);
+    mpz_set_f(scaled_int, scaled);
+
+    *length = int_digits + 1 + num_decimals;
+    str = malloc(*length + 1);
+    mpz_to_digits(str + 1, scaled_int, int_digits + num_decimals, num_threads);
+    memmove(str, str + 1, int_digits);
+    str[int_digits] = '.';
+    str[*length] = '\0';
+
+    //Clear memory
+    mpz_clears(int_part, scaled_int, NULL);
+    mpf_clear(scaled);
+    phase_add(PHASE_CONVERSION, start);
+
+    return str;
+}
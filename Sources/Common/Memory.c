@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "../../Headers/Common/Timers.h"
+#include "../../Headers/Common/Memory.h"
+
+
+/************************************************************************************
+ * Accounting of the GMP memory and operations (--memory)                           *
+ * The allocation functions of GMP are replaced (mp_set_memory_functions) by ones   *
+ * that count the allocations, reallocations, frees and bytes of every thread, and  *
+ * the bytes in use of the process, whose highest value is the peak.                *
+ * The calls to mpf mul, div and add (or sub) are only counted in the builds with   *
+ * the wrappers of Sources/Counters (./compile.sh program counters).                *
+ *                                                                                  *
+ * Every thread keeps its counters without locks. The counters since its last phase *
+ * are added to the phase when the thread times it (phase_add), so the allocations  *
+ * of Chudnovsky_iteration or Bellard_iteration are in Series. When a thread ends,  *
+ * its counters are added to the ones of the exited threads and freed.              *
+ *                                                                                  *
+ ************************************************************************************/
+
+struct memory_thread {
+    int id;                                 // Order of registration
+    struct memory_counters total;
+    struct memory_counters pending;         // Since the last phase of the thread
+    struct memory_thread * next;
+};
+
+int memory_enabled = 0;
+int memory_ops_counted __attribute__((weak)) = 0;     // Defined as 1 by the wrappers (see Sources/Counters)
+struct memory_counters memory_phases[NUM_PHASES];
+struct memory_counters memory_total;
+struct memory_counters memory_exited;                 // Threads that already ended
+struct memory_thread * memory_threads = NULL;         // Threads alive
+int memory_num_threads = 0;
+long memory_in_use = 0;
+long memory_peak = 0;
+pthread_mutex_t memory_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_key_t memory_key;
+
+__thread struct memory_thread * memory_local = NULL;
+
+void * (* gmp_allocate) (size_t);
+void * (* gmp_reallocate) (void *, size_t, size_t);
+void (* gmp_free) (void *, size_t);
+
+void add_counters(struct memory_counters * total, struct memory_counters * counters);
+
+
+/*
+ * Returns the counters of this thread (registered the first time)
+ */
+struct memory_thread * get_memory_thread(){
+    if (memory_local == NULL){
+        memory_local = calloc(1, sizeof(struct memory_thread));
+        pthread_mutex_lock(&memory_lock);
+        memory_local -> id = memory_num_threads++;
+        memory_local -> next = memory_threads;
+        memory_threads = memory_local;
+        pthread_mutex_unlock(&memory_lock);
+        pthread_setspecific(memory_key, memory_local);
+    }
+    return memory_local;
+}
+
+/*
+ * Destructor of the counters of a thread when it ends
+ */
+void release_memory_thread(void * arg){
+    struct memory_thread * counters, ** link;
+
+    counters = (struct memory_thread *) arg;
+    pthread_mutex_lock(&memory_lock);
+    add_counters(&memory_exited, &counters -> total);
+    for(link = &memory_threads; *link != NULL; link = &(*link) -> next){
+        if (*link == counters){
+            *link = counters -> next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&memory_lock);
+    free(counters);
+    memory_local = NULL;
+}
+
+/*
+ * Adds bytes to the memory in use and updates the peak of the process and of the thread
+ */
+void count_bytes(struct memory_thread * counters, long bytes){
+    long in_use, peak;
+
+    in_use = __atomic_add_fetch(&memory_in_use, bytes, __ATOMIC_RELAXED);
+    peak = __atomic_load_n(&memory_peak, __ATOMIC_RELAXED);
+    while(in_use > peak && !__atomic_compare_exchange_n(&memory_peak, &peak, in_use, 1, 
+                                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    if (in_use > counters -> pending.peak) counters -> pending.peak = in_use;
+    if (in_use > counters -> total.peak) counters -> total.peak = in_use;
+}
+
+void * counting_allocate(size_t size){
+    struct memory_thread * counters;
+
+    counters = get_memory_thread();
+    counters -> pending.allocations++;
+    counters -> pending.bytes += size;
+    counters -> total.allocations++;
+    counters -> total.bytes += size;
+    count_bytes(counters, size);
+    return gmp_allocate(size);
+}
+
+void * counting_reallocate(void * pointer, size_t old_size, size_t new_size){
+    struct memory_thread * counters;
+
+    counters = get_memory_thread();
+    counters -> pending.reallocations++;
+    counters -> total.reallocations++;
+    if (new_size > old_size){
+        counters -> pending.bytes += new_size - old_size;
+        counters -> total.bytes += new_size - old_size;
+    }
+    count_bytes(counters, (long) new_size - (long) old_size);
+    return gmp_reallocate(pointer, old_size, new_size);
+}
+
+void counting_free(void * pointer, size_t size){
+    struct memory_thread * counters;
+
+    counters = get_memory_thread();
+    counters -> pending.frees++;
+    counters -> total.frees++;
+    __atomic_sub_fetch(&memory_in_use, size, __ATOMIC_RELAXED);
+    gmp_free(pointer, size);
+}
+
+void count_op(int op){
+    struct memory_thread * counters;
+
+    if (!memory_enabled) return;
+    counters = get_memory_thread();
+    counters -> pending.ops[op]++;
+    counters -> total.ops[op]++;
+}
+
+/*
+ * Replaces the allocation functions of GMP by the counting ones.
+ * IMPORTANT: It must be called before any GMP variable is initialized
+ */
+void start_memory_accounting(){
+    if (memory_enabled) return;
+    pthread_key_create(&memory_key, release_memory_thread);
+    mp_get_memory_functions(&gmp_allocate, &gmp_reallocate, &gmp_free);
+    mp_set_memory_functions(counting_allocate, counting_reallocate, counting_free);
+    memory_enabled = 1;
+}
+
+/*
+ * Clears the counters of every thread and phase (the peak starts from the memory in use).
+ * It must be called when the threads are not working.
+ */
+void reset_memory_counters(){
+    struct memory_thread * counters;
+
+    memset(memory_phases, 0, sizeof(memory_phases));
+    memset(&memory_total, 0, sizeof(memory_total));
+    pthread_mutex_lock(&memory_lock);
+    memset(&memory_exited, 0, sizeof(memory_exited));
+    for(counters = memory_threads; counters != NULL; counters = counters -> next){
+        memset(&counters -> total, 0, sizeof(struct memory_counters));
+        memset(&counters -> pending, 0, sizeof(struct memory_counters));
+    }
+    pthread_mutex_unlock(&memory_lock);
+    memory_peak = memory_in_use;
+}
+
+/*
+ * Adds counters to total (the peak is the highest)
+ */
+void add_counters(struct memory_counters * total, struct memory_counters * counters){
+    int op;
+
+    total -> allocations += counters -> allocations;
+    total -> reallocations += counters -> reallocations;
+    total -> frees += counters -> frees;
+    total -> bytes += counters -> bytes;
+    if (counters -> peak > total -> peak) total -> peak = counters -> peak;
+    for(op = 0; op < NUM_OPS; op++) total -> ops[op] += counters -> ops[op];
+}
+
+/*
+ * Adds the counters of this thread since its last phase to the phase
+ */
+void account_phase_memory(int phase){
+    struct memory_thread * counters;
+
+    if (!memory_enabled) return;
+    counters = get_memory_thread();
+    pthread_mutex_lock(&memory_lock);
+    add_counters(&memory_phases[phase], &counters -> pending);
+    pthread_mutex_unlock(&memory_lock);
+    memset(&counters -> pending, 0, sizeof(struct memory_counters));
+    counters -> pending.peak = __atomic_load_n(&memory_in_use, __ATOMIC_RELAXED);
+}
+
+/*
+ * Adds the counters of all the threads (alive or exited) in memory_total (with the peak of the process)
+ */
+void collect_memory_counters(){
+    struct memory_thread * counters;
+
+    pthread_mutex_lock(&memory_lock);
+    memory_total = memory_exited;
+    for(counters = memory_threads; counters != NULL; counters = counters -> next){
+        add_counters(&memory_total, &counters -> total);
+    }
+    pthread_mutex_unlock(&memory_lock);
+    memory_total.peak = memory_peak;
+}
+
+void print_counters(char * name, struct memory_counters * counters){
+    printf("      %-18s %-12ld %-12ld %-12ld %-14ld %-14ld ", name, counters -> allocations, 
+                counters -> reallocations, counters -> frees, counters -> bytes, counters -> peak);
+    if (memory_ops_counted) printf("%-10ld %-10ld %-10ld \n", counters -> ops[OP_MUL], counters -> ops[OP_DIV], counters -> ops[OP_ADD]);
+    else printf("%-10s %-10s %-10s \n", "-", "-", "-");
+}
+
+/*
+ * Prints the counters of every phase and the total (collect_memory_counters) and, 
+ * if detailed is not 0, the counters of every thread
+ */
+void print_memory(int detailed){
+    int phase, thread;
+    char name[32];
+    struct memory_thread * counters;
+
+    if (!memory_enabled) return;
+    printf("  GMP memory and operations: \n");
+    printf("      %-18s %-12s %-12s %-12s %-14s %-14s %-10s %-10s %-10s \n", "", "Allocations", "Reallocs", 
+                "Frees", "Bytes", "Peak bytes", "mul", "div", "add");
+    for(phase = 0; phase < NUM_PHASES; phase++){
+        if (memory_phases[phase].allocations + memory_phases[phase].reallocations + memory_phases[phase].frees +
+                memory_phases[phase].ops[OP_MUL] + memory_phases[phase].ops[OP_DIV] + memory_phases[phase].ops[OP_ADD] > 0){
+            print_counters(phase_names[phase], &memory_phases[phase]);
+        }
+    }
+    print_counters("Total", &memory_total);
+    if (detailed){
+        pthread_mutex_lock(&memory_lock);
+        for(thread = 0; thread < memory_num_threads; thread++){
+            for(counters = memory_threads; counters != NULL && counters -> id != thread; counters = counters -> next);
+            if (counters == NULL) continue;
+            sprintf(name, "Thread %d", thread);
+            print_counters(name, &counters -> total);
+        }
+        if (memory_exited.allocations + memory_exited.reallocations + memory_exited.frees > 0){
+            print_counters("Exited threads", &memory_exited);
+        }
+        pthread_mutex_unlock(&memory_lock);
+    }
+}
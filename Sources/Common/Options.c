@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../Headers/Common/Options.h"
+
+/*
+ * Optional running properties with their default values
+ */
+struct options run_options = {
+    EQUAL_DISTRIBUTION,     // distribution
+    NULL,                   // calibration_file
+    0,                      // overlap
+    0,                      // shm
+    NULL,                   // checkpoint_file
+    60,                     // checkpoint_interval
+    0,                      // resume
+    NULL,                   // output_file
+    DECIMAL_FORMAT,         // output_format
+    0,                      // digits_per_file
+    NULL,                   // reference_file
+    NULL,                   // report_file
+    0,                      // imbalance
+    NULL,                   // trace_file
+    0,                      // memory
+    0                       // perf
+};
+
+/*
+ * Reads the optional params, given as pairs "--name value" (or just "--name" for 
+ * the flags) after the mandatory ones (from argv[first_option]), and stores them in run_options.
+ * It returns 0 if every option is correct and -1 otherwise.
+ */
+int parse_options(int argc, char ** argv, int first_option){
+    int i;
+    char * name, * value;
+
+    for(i = first_option; i < argc; i++){
+        name = argv[i];
+
+        //Options without value
+        if (strcmp(name, "--overlap") == 0){
+            run_options.overlap = 1;
+            continue;
+        }
+        if (strcmp(name, "--shm") == 0){
+            run_options.shm = 1;
+            continue;
+        }
+        if (strcmp(name, "--resume") == 0){
+            run_options.resume = 1;
+            continue;
+        }
+        if (strcmp(name, "--imbalance") == 0){
+            run_options.imbalance = 1;
+            continue;
+        }
+        if (strcmp(name, "--memory") == 0){
+            run_options.memory = 1;
+            continue;
+        }
+        if (strcmp(name, "--perf") == 0){
+            run_options.perf = 1;
+            continue;
+        }
+
+        if (i + 1 >= argc) return -1;
+        value = argv[++i];
+
+        if (strcmp(name, "--distribution") == 0){
+            if (strcmp(value, "equal") == 0) run_options.distribution = EQUAL_DISTRIBUTION;
+            else if (strcmp(value, "weighted") == 0) run_options.distribution = WEIGHTED_DISTRIBUTION;
+            else if (strcmp(value, "dynamic") == 0) run_options.distribution = DYNAMIC_DISTRIBUTION;
+            else return -1;
+
+        } else if (strcmp(name, "--calibration") == 0){
+            run_options.calibration_file = value;
+
+        } else if (strcmp(name, "--checkpoint") == 0){
+            run_options.checkpoint_file = value;
+
+        } else if (strcmp(name, "--checkpoint-interval") == 0){
+            run_options.checkpoint_interval = atoi(value);
+            if (run_options.checkpoint_interval <= 0) return -1;
+
+        } else if (strcmp(name, "--output") == 0){
+            run_options.output_file = value;
+
+        } else if (strcmp(name, "--format") == 0){
+            if (strcmp(value, "dec") == 0) run_options.output_format = DECIMAL_FORMAT;
+            else if (strcmp(value, "hex") == 0) run_options.output_format = HEX_FORMAT;
+            else if (strcmp(value, "packed") == 0) run_options.output_format = PACKED_FORMAT;
+            else if (strcmp(value, "packed-hex") == 0) run_options.output_format = PACKED_HEX_FORMAT;
+            else if (strcmp(value, "reference") == 0) run_options.output_format = REFERENCE_FORMAT;
+            else return -1;
+
+        } else if (strcmp(name, "--digits-per-file") == 0){
+            run_options.digits_per_file = atol(value);
+            if (run_options.digits_per_file <= 0) return -1;
+
+        } else if (strcmp(name, "--reference") == 0){
+            run_options.reference_file = value;
+
+        } else if (strcmp(name, "--report") == 0){
+            run_options.report_file = value;
+
+        } else if (strcmp(name, "--trace") == 0){
+            run_options.trace_file = value;
+
+        } else {
+            return -1;
+        }
+    }
+
+    //The packed formats are a single file read in place
+    if (run_options.digits_per_file > 0 && (run_options.output_format == PACKED_FORMAT ||
+            run_options.output_format == PACKED_HEX_FORMAT || run_options.output_format == REFERENCE_FORMAT)){
+        printf("  --digits-per-file can not be used with the packed and reference formats \n");
+        return -1;
+    }
+    return 0;
+}
+
+void print_options_usage(){
+    printf("  Options: \n");
+    printf("    --distribution equal|weighted|dynamic -> Iterations per process for BBP and Bellard (MPI) \n");
+    printf("          equal    -> Same number of iterations in every process (default) \n");
+    printf("          weighted -> Iterations proportional to the throughput of every process \n");
+    printf("          dynamic  -> Weighted, and the last iterations are taken by the processes that finish first \n");
+    printf("    --calibration file -> File with the throughput of each node (\"processor_name iterations_per_second\") \n");
+    printf("    --overlap -> Reduce the partial sum of each thread among the processes as soon as it finishes (MPI) \n");
+    printf("    --shm -> Add the partial sums of the processes of each node in shared memory before the reduction (MPI) \n");
+    printf("    --checkpoint file -> Save the state of BBP and Chudnovsky (last versions) periodically in file (Sequential and OMP); \n");
+    printf("                         in MPI, every process saves the state of any algorithm in file.proc_id \n");
+    printf("    --checkpoint-interval seconds -> Time between checkpoints (60 by default) \n");
+    printf("    --resume -> Continue from the checkpoint file, if it exists \n");
+    printf("    --output file -> Write the digits of Pi in file (and the offsets of its chunks in file.idx); \n");
+    printf("                     in MPI, the decimals are converted and written by every process \n");
+    printf("    --format dec|hex|packed|packed-hex|reference -> Digits written in decimal (default) or hexadecimal, \n");
+    printf("                     as text or packed in binary words with checksums; reference writes the packed \n");
+    printf("                     decimals and the hashes of their chunks in file.hash, to be used with --reference \n");
+    printf("    --digits-per-file n -> Split the output in file.0, file.1, ... of n characters each (dec and hex formats) \n");
+    printf("    --reference file -> Check the decimals with a reference store instead of Resources/numeroPiCorrecto.txt \n");
+    printf("    --report file -> Save the properties, results and time of every phase of the run as JSON \n");
+    printf("    --imbalance -> Print the iterations, busy time and wait time of every thread (OMP and MPI) \n");
+    printf("    --trace file -> Save the timeline of the phases of every thread (and process) as Chrome Trace Event JSON \n");
+    printf("    --memory -> Count the GMP allocations, bytes and mpf mul/div/add calls (./compile.sh program counters) of every phase (and thread) \n");
+    printf("    --perf -> Count the cycles, instructions, LLC misses and branch misses of every phase (and thread) \n");
+}
@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <gmp.h>
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/Common/Conversion.h"
+#include "../../Headers/Common/Check_decimals.h"
+#include "../../Headers/Common/Packed.h"
+#include "../../Headers/Common/Output.h"
+#include "../../Headers/Common/Pipeline.h"
+#include "../../Headers/Common/Reference.h"
+#include "../../Headers/Common/Timers.h"
+
+#define OUTPUT_CHUNK (1 << 20)              // Bytes of each write (and chunk of the index)
+
+
+/************************************************************************************
+ * Output of the digits (--output file, --format, --digits-per-file)                *
+ * The decimals are converted, checked and written in a pipeline (see Pipeline).    *
+ * The hexadecimal digits are saved by a writer thread while the decimals are       *
+ * converted and checked.                                                           *
+ *                                                                                  *
+ * The digits are written in chunks of OUTPUT_CHUNK bytes, so every write starts at *
+ * an offset of the file aligned to the chunk size. With --digits-per-file, the     *
+ * text is split in file.0, file.1, ... of n characters each. The chunks are listed *
+ * in file.idx, one per line:                                                       *
+ *      file_name offset_in_file first_character characters                         *
+ * where first_character is the position of the chunk in the whole text.            *
+ * The packed formats and the reference stores are saved and read back in place     *
+ * instead (see Packed and Reference).                                              *
+ *                                                                                  *
+ ************************************************************************************/
+
+struct output_job {
+    char * text;
+    long length;
+    char * file_name;
+    long per_file;                          // Characters of each file (0 = one file)
+    int error;
+};
+
+
+/*
+ * Writes all the bytes, even if the system writes less in each call
+ */
+int write_all(int fd, char * buffer, long length){
+    long written;
+
+    while(length > 0){
+        written = write(fd, buffer, length);
+        if (written < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buffer += written;
+        length -= written;
+    }
+    return 0;
+}
+
+/*
+ * Prepares the output in file_name (split in files of per_file characters if it is not 0),
+ * so the text can be written in pieces of any size with write_output_sink.
+ * It returns 0, or -1 if the index file could not be created.
+ */
+int open_output_sink(struct output_sink * sink, char * file_name, long per_file){
+    char * index_name;
+
+    sink -> file_name = file_name;
+    sink -> per_file = per_file;
+    sink -> fd = -1;
+    sink -> file_index = 0;
+    sink -> file_offset = 0;
+    sink -> position = 0;
+    sink -> buffered = 0;
+    sink -> error = 0;
+    sink -> name = malloc(strlen(file_name) + 24);
+    sink -> buffer = malloc(OUTPUT_CHUNK);
+
+    index_name = malloc(strlen(file_name) + 5);
+    sprintf(index_name, "%s.idx", file_name);
+    sink -> index = fopen(index_name, "w");
+    free(index_name);
+    if (sink -> index == NULL){
+        sink -> error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Writes the buffered chunk at the end of the current file and lists it in the index
+ */
+void flush_output_sink(struct output_sink * sink){
+    if (sink -> buffered == 0) return;
+
+    if (write_all(sink -> fd, sink -> buffer, sink -> buffered) != 0) sink -> error = 1;
+    fprintf(sink -> index, "%s %ld %ld %ld\n", sink -> name, sink -> file_offset, sink -> position, sink -> buffered);
+    sink -> file_offset += sink -> buffered;
+    sink -> position += sink -> buffered;
+    sink -> buffered = 0;
+}
+
+void write_output_sink(struct output_sink * sink, char * text, long length){
+    long piece;
+
+    while(length > 0 && !sink -> error){
+        //The next file is opened when the current one is full (and there is more text)
+        if (sink -> fd < 0 || (sink -> per_file > 0 && sink -> file_offset == sink -> per_file)){
+            if (sink -> fd >= 0 && close(sink -> fd) != 0) sink -> error = 1;
+            if (sink -> per_file > 0) sprintf(sink -> name, "%s.%d", sink -> file_name, sink -> file_index++);
+            else strcpy(sink -> name, sink -> file_name);
+            sink -> fd = open(sink -> name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            sink -> file_offset = 0;
+            if (sink -> fd < 0){
+                sink -> error = 1;
+                break;
+            }
+        }
+
+        piece = OUTPUT_CHUNK - sink -> buffered;
+        if (sink -> per_file > 0 && piece > sink -> per_file - sink -> file_offset - sink -> buffered){
+            piece = sink -> per_file - sink -> file_offset - sink -> buffered;
+        }
+        if (piece > length) piece = length;
+        memcpy(sink -> buffer + sink -> buffered, text, piece);
+        sink -> buffered += piece;
+        text += piece;
+        length -= piece;
+
+        if (sink -> buffered == OUTPUT_CHUNK || 
+                (sink -> per_file > 0 && sink -> file_offset + sink -> buffered == sink -> per_file)){
+            flush_output_sink(sink);
+        }
+    }
+}
+
+/*
+ * Writes the rest of the text and the end of line, and closes the files.
+ * It returns 0, or -1 if any write failed.
+ */
+int close_output_sink(struct output_sink * sink){
+    if (!sink -> error && sink -> fd >= 0){
+        flush_output_sink(sink);
+        if (write_all(sink -> fd, "\n", 1) != 0) sink -> error = 1;
+    }
+    if (sink -> fd >= 0 && close(sink -> fd) != 0) sink -> error = 1;
+    if (sink -> index != NULL && fclose(sink -> index) != 0) sink -> error = 1;
+    free(sink -> name);
+    free(sink -> buffer);
+
+    return (sink -> error) ? -1 : 0;
+}
+
+void * output_writer(void * arg){
+    struct output_job * job;
+    struct output_sink sink;
+
+    job = (struct output_job *) arg;
+    if (open_output_sink(&sink, job -> file_name, job -> per_file) == 0){
+        write_output_sink(&sink, job -> text, job -> length);
+    }
+    if (close_output_sink(&sink) != 0) job -> error = 1;
+
+    return NULL;
+}
+
+/*
+ * Returns a new string (in the heap) with the integer part of value and its first
+ * num_digits hexadecimal digits ("3.243f...").
+ */
+char * mpf_to_hex_string(mpf_t value, long num_digits, long * length){
+    long int_digits;
+    double start;
+    char * digits, * str;
+    mpz_t scaled_int;
+    mpf_t scaled;
+
+    start = phase_clock();
+    mpz_init(scaled_int);
+    mpf_init2(scaled, mpf_get_prec(value));
+    mpf_mul_2exp(scaled, value, 4 * num_digits);
+    mpz_set_f(scaled_int, scaled);
+    digits = mpz_get_str(NULL, 16, scaled_int);
+
+    int_digits = strlen(digits) - num_digits;
+    if (int_digits < 1) int_digits = 1;
+    *length = int_digits + 1 + num_digits;
+    str = malloc(*length + 1);
+    memset(str, '0', *length);
+    strcpy(str + *length - strlen(digits), digits);
+    memmove(str, str + 1, int_digits);
+    str[int_digits] = '.';
+
+    //Clear memory
+    free(digits);
+    mpz_clear(scaled_int);
+    mpf_clear(scaled);
+    phase_add(PHASE_CONVERSION, start);
+
+    return str;
+}
+
+/*
+ * Saves the digits in a packed file (see Packed). The decimals are checked
+ * reading the file, so the check also tells if it was written right.
+ */
+int write_and_check_packed(mpf_t pi, long num_decimals){
+    int base;
+    long num_digits;
+    struct packed_file packed;
+
+    base = (run_options.output_format == PACKED_HEX_FORMAT) ? 16 : 10;
+    num_digits = (base == 16) ? (long) (num_decimals * 0.83048202372184) : num_decimals;
+    if (write_packed_file(run_options.output_file, pi, num_digits, base, 0) != 0){
+        printf("  Output file %s could not be written \n", run_options.output_file);
+        return check_decimals(pi);
+    }
+    if (base == 10) return check_decimals_packed(run_options.output_file);
+
+    if (open_packed(run_options.output_file, &packed) != 0 || verify_packed(&packed) >= 0){
+        printf("  Output file %s is not correct \n", run_options.output_file);
+    } else {
+        close_packed(&packed);
+    }
+    return check_decimals(pi);
+}
+
+/*
+ * Saves the decimals as a reference store (see Reference): the packed decimals and
+ * the hashes of their chunks. The stored decimals are checked as in write_and_check_packed.
+ */
+int write_and_check_reference(mpf_t pi, long num_decimals){
+    if (write_packed_file(run_options.output_file, pi, num_decimals, 10, 0) != 0 ||
+            write_reference_hashes(run_options.output_file, 0) != 0){
+        printf("  Reference store %s could not be written \n", run_options.output_file);
+        return check_decimals(pi);
+    }
+    printf("  Reference store written to %s and %s.hash \n", run_options.output_file, run_options.output_file);
+    return check_decimals_packed(run_options.output_file);
+}
+
+/*
+ * Writes the first num_decimals decimals of pi (or the hexadecimal digits with the
+ * same precision) in the output file of the options, while the decimals are checked.
+ * It returns the number of decimals that match, as check_decimals.
+ */
+int write_and_check_decimals(mpf_t pi, long num_decimals){
+    int decimals, writing;
+    long bytes_of_pi;
+    char * calculated_pi;
+    pthread_t writer;
+    struct output_job job;
+
+    if (run_options.output_format == PACKED_FORMAT || run_options.output_format == PACKED_HEX_FORMAT){
+        return write_and_check_packed(pi, num_decimals);
+    }
+    if (run_options.output_format == REFERENCE_FORMAT) return write_and_check_reference(pi, num_decimals);
+    if (run_options.output_format == DECIMAL_FORMAT){
+        return pipeline_check_decimals(pi, run_options.output_file, run_options.digits_per_file, num_decimals);
+    }
+
+    //Hexadecimal digits: they are written while the decimals are converted and checked
+    job.file_name = run_options.output_file;
+    job.per_file = run_options.digits_per_file;
+    job.error = 0;
+    job.text = mpf_to_hex_string(pi, (long) (num_decimals * 0.83048202372184), &job.length);
+
+    writing = (pthread_create(&writer, NULL, output_writer, &job) == 0);
+    if (!writing) output_writer(&job);
+    calculated_pi = mpf_to_decimal_string(pi, get_mpf_decimals(pi), 0, &bytes_of_pi);
+    decimals = check_decimals_string(calculated_pi, bytes_of_pi);
+    if (writing) pthread_join(writer, NULL);
+    if (job.error) printf("  Output file %s could not be written \n", run_options.output_file);
+
+    //Clear memory
+    free(calculated_pi);
+    free(job.text);
+
+    return decimals;
+}
@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <gmp.h>
+#include "../../Headers/Common/Conversion.h"
+#include "../../Headers/Common/Packed.h"
+#include "../../Headers/Common/Timers.h"
+
+#define PACKED_ALIGNMENT 4096               // The words start at an offset multiple of it
+
+
+/************************************************************************************
+ * Packed digits (--format packed|packed-hex)                                       *
+ * The digits after the point are stored as 64-bit words: 19 decimal digits per     *
+ * word (the number they form, < 10^19), or 16 hexadecimal digits (raw nibbles).    *
+ * The last word is filled with zeros.                                              *
+ *                                                                                  *
+ * File format (binary, native byte order):                                         *
+ *   Header: struct packed_header                                                   *
+ *   Blocks: struct packed_block per block of PACKED_BLOCK_WORDS words, with its    *
+ *           offset in the file, its first digit and the checksum of its words      *
+ *   Words:  from data_offset (aligned to PACKED_ALIGNMENT), the highest first      *
+ *                                                                                  *
+ * So the digits from first to last are in the words first / digits_per_word to     *
+ * last / digits_per_word, which can be read with one pread (or used in place from  *
+ * a mmap of the file).                                                             *
+ *                                                                                  *
+ ************************************************************************************/
+
+
+/*
+ * FNV-1a hash of the bytes of the words
+ */
+uint64_t packed_checksum(uint64_t * words, long num_words){
+    long i;
+    uint64_t hash;
+    unsigned char * bytes;
+
+    hash = 14695981039346656037UL;
+    bytes = (unsigned char *) words;
+    for(i = 0; i < num_words * (long) sizeof(uint64_t); i++){
+        hash ^= bytes[i];
+        hash *= 1099511628211UL;
+    }
+    return hash;
+}
+
+/*
+ * Gets the words with the first num_digits digits of value after the point,
+ * in base 10 (19 digits per word) or 16 (16 digits per word).
+ * It returns the words (in the heap) and stores the integer part of value in int_part.
+ */
+uint64_t * mpf_to_packed_words(mpf_t value, long num_digits, int base, int num_threads,
+                                    long * num_words, uint64_t * int_part){
+    int digits_per_word;
+    double start;
+    size_t exported;
+    uint64_t * words;
+    mpz_t scaled_int, power;
+    mpf_t fraction, scaled;
+
+    start = phase_clock();
+    digits_per_word = (base == 16) ? 16 : 19;
+    *num_words = (num_digits + digits_per_word - 1) / digits_per_word;
+    words = calloc(*num_words + 1, sizeof(uint64_t));
+    mpz_inits(scaled_int, power, NULL);
+    mpf_init2(fraction, mpf_get_prec(value) + 64);
+    mpf_init2(scaled, mpf_get_prec(value) + 4 * digits_per_word * *num_words);
+
+    mpz_set_f(scaled_int, value);
+    *int_part = mpz_get_ui(scaled_int);
+    mpf_set_z(fraction, scaled_int);
+    mpf_sub(fraction, value, fraction);
+
+    if (base == 16){
+        //The fraction bits are the nibbles (the digits after num_digits are zero)
+        mpf_mul_2exp(fraction, fraction, 4 * num_digits);
+        mpz_set_f(scaled_int, fraction);
+        mpz_mul_2exp(scaled_int, scaled_int, 4 * (*num_words * 16 - num_digits));
+        mpz_export(words + *num_words - (mpz_sizeinbase(scaled_int, 2) + 63) / 64, &exported,
+                        1, sizeof(uint64_t), 0, 0, scaled_int);
+    } else {
+        mpz_ui_pow_ui(power, 10, num_digits);
+        mpf_set_z(scaled, power);
+        mpf_mul(scaled, scaled, fraction);
+        mpz_set_f(scaled_int, scaled);
+        mpz_ui_pow_ui(power, 10, *num_words * 19 - num_digits);
+        mpz_mul(scaled_int, scaled_int, power);
+        mpz_to_words(words, scaled_int, *num_words, num_threads);
+    }
+
+    //Clear memory
+    mpz_clears(scaled_int, power, NULL);
+    mpf_clears(fraction, scaled, NULL);
+    phase_add(PHASE_CONVERSION, start);
+
+    return words;
+}
+
+/*
+ * Saves the first num_digits digits of value after the point in a packed file
+ * of the given base (10 or 16). It returns 0, or -1 if the file could not be written.
+ */
+int write_packed_file(char * file_name, mpf_t value, long num_digits, int base, int num_threads){
+    int fd, error;
+    long num_words, block, words;
+    uint64_t * data;
+    struct packed_header header;
+    struct packed_block * blocks;
+
+    data = mpf_to_packed_words(value, num_digits, base, num_threads, &num_words, &header.int_part);
+    header.magic = PACKED_MAGIC;
+    header.version = PACKED_VERSION;
+    header.base = base;
+    header.digits_per_word = (base == 16) ? 16 : 19;
+    header.num_digits = num_digits;
+    header.num_words = num_words;
+    header.block_words = PACKED_BLOCK_WORDS;
+    header.num_blocks = (num_words + PACKED_BLOCK_WORDS - 1) / PACKED_BLOCK_WORDS;
+    header.data_offset = sizeof(struct packed_header) + header.num_blocks * sizeof(struct packed_block);
+    header.data_offset = (header.data_offset + PACKED_ALIGNMENT - 1) / PACKED_ALIGNMENT * PACKED_ALIGNMENT;
+
+    blocks = malloc(sizeof(struct packed_block) * (header.num_blocks + 1));
+    for(block = 0; block < (long) header.num_blocks; block++){
+        words = num_words - block * PACKED_BLOCK_WORDS;
+        if (words > PACKED_BLOCK_WORDS) words = PACKED_BLOCK_WORDS;
+        blocks[block].offset = header.data_offset + block * PACKED_BLOCK_WORDS * sizeof(uint64_t);
+        blocks[block].first_digit = block * PACKED_BLOCK_WORDS * header.digits_per_word;
+        blocks[block].num_words = words;
+        blocks[block].checksum = packed_checksum(data + block * PACKED_BLOCK_WORDS, words);
+    }
+
+    error = -1;
+    fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0){
+        error = 0;
+        if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) error = -1;
+        if (pwrite(fd, blocks, header.num_blocks * sizeof(struct packed_block), sizeof(header)) !=
+                    (ssize_t) (header.num_blocks * sizeof(struct packed_block))) error = -1;
+        if (pwrite(fd, data, num_words * sizeof(uint64_t), header.data_offset) !=
+                    (ssize_t) (num_words * sizeof(uint64_t))) error = -1;
+        if (close(fd) != 0) error = -1;
+    }
+
+    //Clear memory
+    free(data);
+    free(blocks);
+
+    return error;
+}
+
+/*
+ * Tells if a range of num_words words from offset is inside a file of size bytes
+ */
+int words_fit(uint64_t offset, uint64_t num_words, size_t size){
+    return offset <= size && num_words <= (size - offset) / sizeof(uint64_t);
+}
+
+/*
+ * Checks the header, the table of blocks and the extent of every block of a mapped file,
+ * so the words can be read without going past the end of the map
+ */
+int packed_extents_fit(struct packed_file * packed){
+    uint64_t block;
+    struct packed_header * header;
+
+    header = packed -> header;
+    if (header -> magic != PACKED_MAGIC || header -> version != PACKED_VERSION) return 0;
+    if (!((header -> base == 10 && header -> digits_per_word == 19) || 
+            (header -> base == 16 && header -> digits_per_word == 16))) return 0;
+    if (header -> num_blocks > (packed -> size - sizeof(struct packed_header)) / sizeof(struct packed_block)) return 0;
+    if (!words_fit(header -> data_offset, header -> num_words, packed -> size)) return 0;
+    for(block = 0; block < header -> num_blocks; block++){
+        if (!words_fit(packed -> blocks[block].offset, packed -> blocks[block].num_words, packed -> size)) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Maps a packed file in memory and checks its header and blocks.
+ * It returns 0, or -1 if it is not a correct packed file.
+ */
+int open_packed(char * file_name, struct packed_file * packed){
+    struct stat file_stat;
+
+    packed -> map = NULL;
+    packed -> fd = open(file_name, O_RDONLY);
+    if (packed -> fd < 0) return -1;
+    if (fstat(packed -> fd, &file_stat) != 0 || file_stat.st_size < (off_t) sizeof(struct packed_header)){
+        close(packed -> fd);
+        return -1;
+    }
+    packed -> size = file_stat.st_size;
+    packed -> map = mmap(NULL, packed -> size, PROT_READ, MAP_SHARED, packed -> fd, 0);
+    if (packed -> map == MAP_FAILED){
+        close(packed -> fd);
+        return -1;
+    }
+
+    packed -> header = (struct packed_header *) packed -> map;
+    packed -> blocks = (struct packed_block *) (packed -> map + sizeof(struct packed_header));
+    packed -> words = (uint64_t *) (packed -> map + packed -> header -> data_offset);
+    if (!packed_extents_fit(packed)){
+        close_packed(packed);
+        return -1;
+    }
+    return 0;
+}
+
+void close_packed(struct packed_file * packed){
+    munmap(packed -> map, packed -> size);
+    close(packed -> fd);
+}
+
+/*
+ * Checks the checksum of every block. It returns the first incorrect block, or -1.
+ */
+long verify_packed(struct packed_file * packed){
+    long block;
+
+    for(block = 0; block < (long) packed -> header -> num_blocks; block++){
+        if (packed_checksum((uint64_t *) (packed -> map + packed -> blocks[block].offset),
+                                packed -> blocks[block].num_words) != packed -> blocks[block].checksum){
+            return block;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Writes the ASCII digits of a word in out (digits_per_word characters)
+ */
+void packed_word_to_digits(char * out, uint64_t word, int base){
+    int i;
+
+    if (base == 16){
+        for(i = 15; i >= 0; i--){
+            out[i] = "0123456789abcdef"[word & 0xF];
+            word >>= 4;
+        }
+    } else {
+        word_to_digits(out, word);
+    }
+}
+
+/*
+ * Reads the count digits from first (0 is the first digit after the point) with one pread
+ * and stores them in out as ASCII. It returns the number of digits read.
+ */
+long read_packed_digits(int fd, struct packed_header * header, long first, long count, char * out){
+    long first_word, num_words, word, skip, copied, length;
+    uint64_t * words;
+    char digits[19];
+
+    if (first >= (long) header -> num_digits) return 0;
+    if (first + count > (long) header -> num_digits) count = header -> num_digits - first;
+    first_word = first / header -> digits_per_word;
+    num_words = (first + count - 1) / header -> digits_per_word - first_word + 1;
+    words = malloc(num_words * sizeof(uint64_t));
+    if (pread(fd, words, num_words * sizeof(uint64_t), header -> data_offset + first_word * sizeof(uint64_t)) !=
+                (ssize_t) (num_words * sizeof(uint64_t))){
+        free(words);
+        return 0;
+    }
+
+    copied = 0;
+    skip = first % header -> digits_per_word;
+    for(word = 0; word < num_words; word++){
+        packed_word_to_digits(digits, words[word], header -> base);
+        length = header -> digits_per_word - skip;
+        if (length > count - copied) length = count - copied;
+        memcpy(out + copied, digits + skip, length);
+        copied += length;
+        skip = 0;
+    }
+
+    free(words);
+    return copied;
+}
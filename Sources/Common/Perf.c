@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "../../Headers/Common/Timers.h"
+#include "../../Headers/Common/Perf.h"
+
+
+/************************************************************************************
+ * Hardware performance counters of every phase (--perf)                            *
+ * Every thread opens its own counters (perf_event_open, only user space) of the    *
+ * cycles, instructions, last level cache misses and branch misses when it starts   *
+ * its first phase. The counters are read when a phase starts (phase_clock) and     *
+ * when it ends (phase_add), and the difference is added to the phase, so the work  *
+ * of the thread between phases is only in its total. The counts are scaled if the  *
+ * kernel multiplexed the counters. When a thread ends, its counters are closed and *
+ * its counts are added to the ones of the exited threads.                          *
+ *                                                                                  *
+ * The instructions per cycle and the cache misses per thousand instructions tell   *
+ * the memory-bound phases (reductions, verification) from the compute-bound ones   *
+ * (the divisions of the series). The counters that the system does not provide     *
+ * (e.g. in virtual machines) are printed as n/a.                                   *
+ *                                                                                  *
+ ************************************************************************************/
+
+struct perf_thread {
+    int id;                                 // Order of registration
+    int fds[NUM_PERF_EVENTS];               // -1 if the counter is not available
+    long last[NUM_PERF_EVENTS];             // Counts when its total was last updated
+    double starts[PERF_STARTS];             // Last times returned by phase_clock
+    long readings[PERF_STARTS][NUM_PERF_EVENTS];    // Counts at those times
+    int next_start;
+    struct perf_counters total;
+    struct perf_thread * next;
+};
+
+int perf_enabled = 0;
+int perf_available[NUM_PERF_EVENTS];        // Opened by some thread
+int perf_error = 0;                         // errno of the first counter that could not be opened
+struct perf_counters perf_phases[NUM_PHASES];
+struct perf_counters perf_total;
+struct perf_counters perf_exited;           // Threads that already ended
+struct perf_thread * perf_threads = NULL;   // Threads alive
+int perf_num_threads = 0;
+pthread_mutex_t perf_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_key_t perf_key;
+
+__thread struct perf_thread * perf_local = NULL;
+
+uint64_t perf_configs[NUM_PERF_EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, 
+                                            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+char * perf_names[NUM_PERF_EVENTS] = {"Cycles", "Instructions", "LLC misses", "Branch misses"};
+char * perf_keys[NUM_PERF_EVENTS] = {"cycles", "instructions", "llc_misses", "branch_misses"};
+
+
+void release_perf_thread(void * arg);
+
+void start_perf_counters(){
+    if (perf_enabled) return;
+    pthread_key_create(&perf_key, release_perf_thread);
+    perf_enabled = 1;
+}
+
+/*
+ * Returns the count of the counter, scaled by the time it was really counting
+ */
+long read_perf_counter(int fd){
+    uint64_t data[3];                       // value, time enabled, time running
+
+    if (fd < 0 || read(fd, data, sizeof(data)) != sizeof(data)) return 0;
+    if (data[2] == 0) return 0;
+    if (data[2] < data[1]) return (long) ((double) data[0] * data[1] / data[2]);
+    return (long) data[0];
+}
+
+/*
+ * Opens the counters of this thread, if it has not opened them yet
+ */
+void open_perf_counters(){
+    int event;
+    struct perf_event_attr attr;
+
+    if (!perf_enabled || perf_local != NULL) return;
+    perf_local = calloc(1, sizeof(struct perf_thread));
+    for(event = 0; event < NUM_PERF_EVENTS; event++){
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = perf_configs[event];
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        perf_local -> fds[event] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (perf_local -> fds[event] >= 0) perf_available[event] = 1;
+        else if (perf_error == 0) perf_error = errno;
+    }
+    for(event = 0; event < NUM_PERF_EVENTS; event++) perf_local -> last[event] = read_perf_counter(perf_local -> fds[event]);
+
+    pthread_mutex_lock(&perf_lock);
+    perf_local -> id = perf_num_threads++;
+    perf_local -> next = perf_threads;
+    perf_threads = perf_local;
+    pthread_mutex_unlock(&perf_lock);
+    pthread_setspecific(perf_key, perf_local);
+}
+
+/*
+ * Adds the counts of the thread since they were last added to its total.
+ * If now is not NULL, the current counts are also stored in it.
+ */
+void update_perf_total(struct perf_thread * counters, long * now){
+    int event;
+    long count;
+
+    for(event = 0; event < NUM_PERF_EVENTS; event++){
+        count = read_perf_counter(counters -> fds[event]);
+        counters -> total.values[event] += count - counters -> last[event];
+        counters -> last[event] = count;
+        if (now != NULL) now[event] = count;
+    }
+}
+
+/*
+ * Destructor of the counters of a thread when it ends
+ */
+void release_perf_thread(void * arg){
+    int event;
+    struct perf_thread * counters, ** link;
+
+    counters = (struct perf_thread *) arg;
+    update_perf_total(counters, NULL);
+    for(event = 0; event < NUM_PERF_EVENTS; event++){
+        if (counters -> fds[event] >= 0) close(counters -> fds[event]);
+    }
+    pthread_mutex_lock(&perf_lock);
+    for(event = 0; event < NUM_PERF_EVENTS; event++) perf_exited.values[event] += counters -> total.values[event];
+    for(link = &perf_threads; *link != NULL; link = &(*link) -> next){
+        if (*link == counters){
+            *link = counters -> next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&perf_lock);
+    free(counters);
+    perf_local = NULL;
+}
+
+/*
+ * Reads the counters of this thread at the start of a phase (start is its phase_clock time)
+ */
+void start_phase_perf(double start){
+    int event, slot;
+
+    open_perf_counters();
+    slot = perf_local -> next_start;
+    perf_local -> next_start = (slot + 1) % PERF_STARTS;
+    perf_local -> starts[slot] = start;
+    for(event = 0; event < NUM_PERF_EVENTS; event++){
+        perf_local -> readings[slot][event] = read_perf_counter(perf_local -> fds[event]);
+    }
+}
+
+/*
+ * Clears the counts of every thread and phase.
+ * It must be called when the threads are not working.
+ */
+void reset_perf_counters(){
+    struct perf_thread * counters;
+
+    memset(perf_phases, 0, sizeof(perf_phases));
+    memset(&perf_total, 0, sizeof(perf_total));
+    pthread_mutex_lock(&perf_lock);
+    memset(&perf_exited, 0, sizeof(perf_exited));
+    for(counters = perf_threads; counters != NULL; counters = counters -> next){
+        update_perf_total(counters, NULL);
+        memset(&counters -> total, 0, sizeof(struct perf_counters));
+    }
+    pthread_mutex_unlock(&perf_lock);
+}
+
+/*
+ * Adds the counts of this thread since the start of the phase (its phase_clock time) to the phase.
+ * If the reading of the start was already replaced (more than PERF_STARTS later starts), the
+ * counts are since the oldest reading kept.
+ */
+void account_phase_perf(int phase, double start){
+    int event, slot, oldest;
+    long now[NUM_PERF_EVENTS];
+
+    if (!perf_enabled || perf_local == NULL) return;
+    update_perf_total(perf_local, now);
+    oldest = perf_local -> next_start;
+    for(slot = 0; slot < PERF_STARTS && perf_local -> starts[slot] != start; slot++);
+    if (slot == PERF_STARTS) slot = oldest;
+
+    pthread_mutex_lock(&perf_lock);
+    for(event = 0; event < NUM_PERF_EVENTS; event++){
+        perf_phases[phase].values[event] += now[event] - perf_local -> readings[slot][event];
+    }
+    pthread_mutex_unlock(&perf_lock);
+}
+
+/*
+ * Adds the counts of all the threads (alive or exited) in perf_total
+ */
+void collect_perf_counters(){
+    int event;
+    struct perf_thread * counters;
+
+    pthread_mutex_lock(&perf_lock);
+    perf_total = perf_exited;
+    for(counters = perf_threads; counters != NULL; counters = counters -> next){
+        for(event = 0; event < NUM_PERF_EVENTS; event++) perf_total.values[event] += counters -> total.values[event];
+    }
+    pthread_mutex_unlock(&perf_lock);
+}
+
+void print_perf_counters(char * name, struct perf_counters * counters){
+    int event;
+
+    printf("      %-18s", name);
+    for(event = 0; event < NUM_PERF_EVENTS; event++){
+        if (perf_available[event]) printf(" %-15ld", counters -> values[event]);
+        else printf(" %-15s", "n/a");
+    }
+    if (perf_available[PERF_CYCLES] && perf_available[PERF_INSTRUCTIONS] && counters -> values[PERF_CYCLES] > 0){
+        printf(" %-7.2f", (double) counters -> values[PERF_INSTRUCTIONS] / counters -> values[PERF_CYCLES]);
+    } else {
+        printf(" %-7s", "n/a");
+    }
+    if (perf_available[PERF_INSTRUCTIONS] && perf_available[PERF_LLC_MISSES] && counters -> values[PERF_INSTRUCTIONS] > 0){
+        printf(" %-7.3f", 1000.0 * counters -> values[PERF_LLC_MISSES] / counters -> values[PERF_INSTRUCTIONS]);
+    } else {
+        printf(" %-7s", "n/a");
+    }
+    printf(" \n");
+}
+
+/*
+ * Prints the counts of every phase and the total (collect_perf_counters) with the
+ * instructions per cycle and the LLC misses per thousand instructions and, 
+ * if detailed is not 0, the counts of every thread
+ */
+void print_perf(int detailed){
+    int phase, thread, event, available;
+    char name[32];
+    struct perf_thread * counters;
+
+    if (!perf_enabled) return;
+    available = 0;
+    for(event = 0; event < NUM_PERF_EVENTS; event++) available |= perf_available[event];
+    if (!available){
+        printf("  Performance counters are not available (perf_event_open: %s) \n", strerror(perf_error));
+        return;
+    }
+
+    printf("  Performance counters: \n");
+    printf("      %-18s", "");
+    for(event = 0; event < NUM_PERF_EVENTS; event++) printf(" %-15s", perf_names[event]);
+    printf(" %-7s %-7s \n", "IPC", "LLC MPKI");
+    for(phase = 0; phase < NUM_PHASES; phase++){
+        if (phase_seconds[phase] > 0) print_perf_counters(phase_names[phase], &perf_phases[phase]);
+    }
+    print_perf_counters("Total", &perf_total);
+    if (detailed){
+        pthread_mutex_lock(&perf_lock);
+        for(thread = 0; thread < perf_num_threads; thread++){
+            for(counters = perf_threads; counters != NULL && counters -> id != thread; counters = counters -> next);
+            if (counters == NULL) continue;
+            sprintf(name, "Thread %d", thread);
+            print_perf_counters(name, &counters -> total);
+        }
+        if (perf_exited.values[PERF_CYCLES] + perf_exited.values[PERF_INSTRUCTIONS] > 0){
+            print_perf_counters("Exited threads", &perf_exited);
+        }
+        pthread_mutex_unlock(&perf_lock);
+    }
+}
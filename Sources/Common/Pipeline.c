@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "../../Headers/Common/Conversion.h"
+#include "../../Headers/Common/Output.h"
+#include "../../Headers/Common/Check_decimals.h"
+#include "../../Headers/Common/Timers.h"
+
+#define PIPELINE_CHUNK (1 << 20)            // Digits of each chunk
+#define QUEUE_SIZE 8                        // Chunks of each queue (power of two)
+#define MAX_LEVELS 40
+
+
+/************************************************************************************
+ * Pipeline of the conversion, the check and the output of the decimals             *
+ * The three stages work at the same time on different chunks of digits:            *
+ *                                                                                  *
+ *   convert (thread) --queue--> check (caller) --queue--> write (thread)           *
+ *                                                                                  *
+ * The converter splits the integer with the decimals by powers of ten from the     *
+ * top, so the chunks of the highest digits are converted (with all the threads,    *
+ * see Conversion) and sent first, while the lower half is still binary. The        *
+ * checker compares each chunk with the correct pi number (see Check_decimals), and *
+ * the writer saves the chunks already checked (see Output).                        *
+ * The queues are bounded and lock-free, with one producer and one consumer: each   *
+ * side only moves its own index, so a full or empty queue only makes it yield.     *
+ * The time of the converter waiting for a full queue is not part of the conversion *
+ * phase. If a thread can not be created, its stage is done by the caller.          *
+ *                                                                                  *
+ ************************************************************************************/
+
+struct digit_chunk {
+    char * digits;
+    long length;
+};
+
+struct chunk_queue {
+    struct digit_chunk * chunks[QUEUE_SIZE];
+    unsigned long head;                     // Next chunk to pop (only moved by the consumer)
+    unsigned long tail;                     // Next chunk to push (only moved by the producer)
+};
+
+struct pipeline {
+    mpz_ptr value;                          // floor(pi * 10^decimals)
+    long digits;
+    int num_threads;
+    mpz_t powers[MAX_LEVELS];               // powers[k] = 10^(PIPELINE_CHUNK * 2^k)
+    struct chunk_queue converted, checked;
+    long write_limit;                       // Characters written
+    char * file_name;
+    long per_file;
+    int write_error;
+    double convert_start;                   // Start of the conversion since the last chunk sent
+};
+
+
+void push_chunk(struct chunk_queue * queue, struct digit_chunk * chunk){
+    unsigned long tail;
+
+    tail = queue -> tail;
+    while(tail - __atomic_load_n(&queue -> head, __ATOMIC_ACQUIRE) == QUEUE_SIZE) sched_yield();
+    queue -> chunks[tail % QUEUE_SIZE] = chunk;
+    __atomic_store_n(&queue -> tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * It returns NULL at the end of the digits
+ */
+struct digit_chunk * pop_chunk(struct chunk_queue * queue){
+    unsigned long head;
+    struct digit_chunk * chunk;
+
+    head = queue -> head;
+    while(__atomic_load_n(&queue -> tail, __ATOMIC_ACQUIRE) == head) sched_yield();
+    chunk = queue -> chunks[head % QUEUE_SIZE];
+    __atomic_store_n(&queue -> head, head + 1, __ATOMIC_RELEASE);
+    return chunk;
+}
+
+/*
+ * Sends a converted chunk. The conversion phase stops while the queue is full.
+ */
+void push_converted(struct pipeline * pipe, struct digit_chunk * chunk){
+    phase_add(PHASE_CONVERSION, pipe -> convert_start);
+    push_chunk(&pipe -> converted, chunk);
+    pipe -> convert_start = phase_clock();
+}
+
+/*
+ * Converts value < 10^digits (with leading zeros) and sends its chunks in order.
+ * The high part is converted and sent before the low part is divided again.
+ * IMPORTANT: value is destroyed
+ */
+void convert_chunks(struct pipeline * pipe, mpz_t value, long digits, int level){
+    long low_digits;
+    mpz_t high;
+    struct digit_chunk * chunk;
+
+    if (digits <= PIPELINE_CHUNK || level == 0){
+        chunk = malloc(sizeof(struct digit_chunk));
+        chunk -> digits = malloc(digits);
+        chunk -> length = digits;
+        mpz_to_digits(chunk -> digits, value, digits, pipe -> num_threads);
+        push_converted(pipe, chunk);
+        return;
+    }
+
+    //The low part has the digits of the biggest power below the digits of the piece
+    while(level > 0 && ((long) PIPELINE_CHUNK << (level - 1)) >= digits) level--;
+    low_digits = (long) PIPELINE_CHUNK << (level - 1);
+
+    mpz_init(high);
+    mpz_tdiv_qr(high, value, value, pipe -> powers[level - 1]);
+    convert_chunks(pipe, high, digits - low_digits, level - 1);
+    mpz_clear(high);
+    convert_chunks(pipe, value, low_digits, level - 1);
+}
+
+void * pipeline_converter(void * arg){
+    int level;
+    char * int_string;
+    mpz_t int_part, power;
+    struct pipeline * pipe;
+    struct digit_chunk * chunk;
+
+    pipe = (struct pipeline *) arg;
+    pipe -> convert_start = phase_clock();
+
+    //First chunk: the integer part and the point
+    mpz_inits(int_part, power, NULL);
+    mpz_ui_pow_ui(power, 10, pipe -> digits);
+    mpz_tdiv_qr(int_part, pipe -> value, pipe -> value, power);
+    int_string = mpz_get_str(NULL, 10, int_part);
+    chunk = malloc(sizeof(struct digit_chunk));
+    chunk -> length = strlen(int_string) + 1;
+    chunk -> digits = malloc(chunk -> length + 1);
+    sprintf(chunk -> digits, "%s.", int_string);
+    free(int_string);
+    push_converted(pipe, chunk);
+
+    //Powers of the levels of the division (10^(PIPELINE_CHUNK * 2^k) < 10^digits)
+    level = 0;
+    if (pipe -> digits > PIPELINE_CHUNK){
+        mpz_init(pipe -> powers[0]);
+        mpz_ui_pow_ui(pipe -> powers[0], 10, PIPELINE_CHUNK);
+        level = 1;
+        while(level < MAX_LEVELS && ((long) PIPELINE_CHUNK << level) < pipe -> digits){
+            mpz_init(pipe -> powers[level]);
+            mpz_mul(pipe -> powers[level], pipe -> powers[level - 1], pipe -> powers[level - 1]);
+            level++;
+        }
+    }
+    convert_chunks(pipe, pipe -> value, pipe -> digits, level);
+
+    //Clear memory
+    while(level > 0) mpz_clear(pipe -> powers[--level]);
+    mpz_clears(int_part, power, NULL);
+    push_converted(pipe, NULL);
+    return NULL;
+}
+
+/*
+ * Writes the part of the chunk below the write limit and frees it
+ */
+void write_chunk(struct pipeline * pipe, struct output_sink * sink, struct digit_chunk * chunk, long * written){
+    long length;
+
+    length = (chunk -> length < pipe -> write_limit - *written) ? chunk -> length : pipe -> write_limit - *written;
+    if (length > 0) write_output_sink(sink, chunk -> digits, length);
+    *written += length;
+    free(chunk -> digits);
+    free(chunk);
+}
+
+void * pipeline_writer(void * arg){
+    long written;
+    struct pipeline * pipe;
+    struct digit_chunk * chunk;
+    struct output_sink sink;
+
+    pipe = (struct pipeline *) arg;
+    open_output_sink(&sink, pipe -> file_name, pipe -> per_file);
+    written = 0;
+    while((chunk = pop_chunk(&pipe -> checked)) != NULL) write_chunk(pipe, &sink, chunk, &written);
+    pipe -> write_error = (close_output_sink(&sink) != 0);
+
+    return NULL;
+}
+
+/*
+ * Converts, checks and writes the decimals one stage after the other,
+ * when the converter thread could not be created
+ */
+int serial_check_decimals(mpf_t pi, char * file_name, long per_file, long num_decimals){
+    int decimals;
+    long bytes_of_pi, length;
+    char * calculated_pi;
+    struct output_sink sink;
+
+    calculated_pi = mpf_to_decimal_string(pi, get_mpf_decimals(pi), 0, &bytes_of_pi);
+    decimals = check_decimals_string(calculated_pi, bytes_of_pi);
+    if (file_name != NULL){
+        length = strchr(calculated_pi, '.') - calculated_pi + 1 + num_decimals;
+        if (length > bytes_of_pi) length = bytes_of_pi;
+        if (open_output_sink(&sink, file_name, per_file) == 0) write_output_sink(&sink, calculated_pi, length);
+        if (close_output_sink(&sink) != 0) printf("  Output file %s could not be written \n", file_name);
+    }
+
+    //Clear memory
+    free(calculated_pi);
+
+    return decimals;
+}
+
+/*
+ * Converts pi to decimal and compares it with the correct pi number in a pipeline.
+ * If file_name is not NULL, the first num_decimals decimals are also saved in it
+ * (split in files of per_file characters if it is not 0).
+ * It returns the number of decimals that match, as check_decimals.
+ */
+int pipeline_check_decimals(mpf_t pi, char * file_name, long per_file, long num_decimals){
+    int matching, first_chunk, writing;
+    long matched, compared, written;
+    pthread_t converter, writer;
+    mpz_t value;
+    mpf_t scaled;
+    struct pipeline pipe;
+    struct digit_chunk * chunk;
+    struct output_sink sink;
+
+    //Integer with all the decimals that can be accurately represented
+    memset(&pipe, 0, sizeof(pipe));
+    pipe.digits = get_mpf_decimals(pi);
+    pipe.num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    pipe.file_name = file_name;
+    pipe.per_file = per_file;
+    mpz_init(value);
+    mpf_init2(scaled, mpf_get_prec(pi) + 4 * pipe.digits);
+    mpz_ui_pow_ui(value, 10, pipe.digits);
+    mpf_set_z(scaled, value);
+    mpf_mul(scaled, scaled, pi);
+    mpz_set_f(value, scaled);
+    mpf_clear(scaled);
+    pipe.value = value;
+
+    if (pthread_create(&converter, NULL, pipeline_converter, &pipe) != 0){
+        mpz_clear(value);
+        return serial_check_decimals(pi, file_name, per_file, num_decimals);
+    }
+    //Without the writer thread, the checked chunks are written by the caller
+    writing = (file_name != NULL && pthread_create(&writer, NULL, pipeline_writer, &pipe) == 0);
+    if (file_name != NULL && !writing) open_output_sink(&sink, file_name, per_file);
+
+    //Check stage
+    matched = 0;
+    written = 0;
+    matching = 1;
+    first_chunk = 1;
+    while((chunk = pop_chunk(&pipe.converted)) != NULL){
+        //The integer part and the point are written before num_decimals decimals
+        if (first_chunk) pipe.write_limit = chunk -> length + num_decimals;
+        first_chunk = 0;
+        if (matching){
+            compared = compare_correct_pi(chunk -> digits, chunk -> length, matched);
+            matching = (compared == chunk -> length);
+            matched += compared;
+        }
+        if (writing){
+            push_chunk(&pipe.checked, chunk);
+        } else if (file_name != NULL){
+            write_chunk(&pipe, &sink, chunk, &written);
+        } else {
+            free(chunk -> digits);
+            free(chunk);
+        }
+    }
+
+    pthread_join(converter, NULL);
+    if (writing){
+        push_chunk(&pipe.checked, NULL);
+        pthread_join(writer, NULL);
+    } else if (file_name != NULL){
+        pipe.write_error = (close_output_sink(&sink) != 0);
+    }
+    if (pipe.write_error) printf("  Output file %s could not be written \n", file_name);
+
+    //Clear memory
+    mpz_clear(value);
+
+    return (matched < 2) ? 0 : matched - 2;
+}
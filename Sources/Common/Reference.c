@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/Common/Conversion.h"
+#include "../../Headers/Common/Packed.h"
+#include "../../Headers/Common/Check_decimals.h"
+#include "../../Headers/Common/Reference.h"
+
+
+/************************************************************************************
+ * Reference store (--format reference to make it, --reference to use it)           *
+ * A store is a packed decimal file (see Packed) plus file.hash, with the hash of   *
+ * every chunk of REFERENCE_CHUNK decimals of the text:                             *
+ *   Header: struct reference_header                                                *
+ *   Hashes: one uint64_t per chunk, from the first decimals                        *
+ *                                                                                  *
+ * A store is made from a run already checked with the current reference, and it    *
+ * is cross-verified by checking it with a run of another algorithm.                *
+ * To check a run, the whole chunks of its digits are hashed by several threads     *
+ * and only the hashes are compared; only the first chunk that does not match and   *
+ * the pieces of the digits that do not fill a chunk are read from the packed file  *
+ * (with one pread each). So only the hashes are kept in memory.                    *
+ *                                                                                  *
+ ************************************************************************************/
+
+struct hash_task {
+    char * computed;                        // Digits of the first chunk (only to check)
+    struct packed_file * packed;            // Packed file (only to make the hashes)
+    long first_chunk;
+    long begin;                             // Chunks of this task, relative to first_chunk
+    long end;
+    long * bad;                             // First chunk that does not match (checking)
+};
+
+struct reference_header reference_header;
+uint64_t * reference_hashes = NULL;
+int reference_fd = -1;                      // Packed file with the digits of the store
+struct packed_header reference_packed;
+char reference_int[24];                     // Integer part and point
+long reference_int_length;
+
+
+/*
+ * Hash of a piece of text, 8 bytes at a time (it detects errors, it is not cryptographic)
+ */
+uint64_t hash_digits(char * digits, long length){
+    long i;
+    uint64_t hash, word;
+
+    hash = 0x9E3779B97F4A7C15UL ^ (uint64_t) length;
+    for(i = 0; i + 8 <= length; i += 8){
+        memcpy(&word, digits + i, 8);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDUL;
+        hash ^= hash >> 32;
+    }
+    if (i < length){
+        word = 0;
+        memcpy(&word, digits + i, length - i);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDUL;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+/*
+ * Decimals of the chunk of a store (the last one can be shorter)
+ */
+long chunk_length(struct reference_header * header, long chunk){
+    long first;
+
+    first = chunk * header -> chunk_digits;
+    return ((long) header -> num_digits - first < (long) header -> chunk_digits) ?
+                (long) header -> num_digits - first : (long) header -> chunk_digits;
+}
+
+void * hash_packed_chunks(void * arg){
+    int d, skip;
+    long chunk, digit, word, copied, length;
+    char * digits, word_digits[19];
+    struct hash_task * task;
+
+    task = (struct hash_task *) arg;
+    digits = malloc(REFERENCE_CHUNK);
+    for(chunk = task -> begin; chunk < task -> end; chunk++){
+        length = chunk_length(&reference_header, chunk);
+        digit = chunk * REFERENCE_CHUNK;
+        word = digit / 19;
+        skip = digit % 19;
+        for(copied = 0; copied < length; word++){
+            word_to_digits(word_digits, task -> packed -> words[word]);
+            for(d = skip; d < 19 && copied < length; d++) digits[copied++] = word_digits[d];
+            skip = 0;
+        }
+        reference_hashes[chunk] = hash_digits(digits, length);
+    }
+    free(digits);
+    return NULL;
+}
+
+/*
+ * Makes file_name.hash from the packed decimal file file_name with num_threads threads
+ * (the number of processors online if it is 0). It returns 0, or -1 if it failed.
+ */
+int write_reference_hashes(char * file_name, int num_threads){
+    int thread, created, error;
+    long part;
+    char * hash_name;
+    pthread_t * threads;
+    struct hash_task * tasks;
+    struct packed_file packed;
+    FILE * file;
+
+    if (open_packed(file_name, &packed) != 0) return -1;
+    if (packed.header -> base != 10 || verify_packed(&packed) >= 0){
+        close_packed(&packed);
+        return -1;
+    }
+
+    reference_header.magic = REFERENCE_MAGIC;
+    reference_header.version = REFERENCE_VERSION;
+    reference_header.int_part = packed.header -> int_part;
+    reference_header.num_digits = packed.header -> num_digits;
+    reference_header.chunk_digits = REFERENCE_CHUNK;
+    reference_header.num_chunks = (packed.header -> num_digits + REFERENCE_CHUNK - 1) / REFERENCE_CHUNK;
+    free(reference_hashes);
+    reference_hashes = malloc(sizeof(uint64_t) * (reference_header.num_chunks + 1));
+
+    //The chunks are hashed in parallel
+    if (num_threads <= 0) num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads > (long) reference_header.num_chunks) num_threads = reference_header.num_chunks;
+    if (num_threads < 1) num_threads = 1;
+    threads = malloc(sizeof(pthread_t) * num_threads);
+    tasks = malloc(sizeof(struct hash_task) * num_threads);
+    part = reference_header.num_chunks / num_threads;
+    for(thread = 0; thread < num_threads; thread++){
+        tasks[thread].packed = &packed;
+        tasks[thread].begin = thread * part;
+        tasks[thread].end = (thread == num_threads - 1) ? (long) reference_header.num_chunks : (thread + 1) * part;
+    }
+    created = 1;
+    while(created < num_threads && pthread_create(&threads[created], NULL, hash_packed_chunks, &tasks[created]) == 0) created++;
+    hash_packed_chunks(&tasks[0]);
+    for(thread = created; thread < num_threads; thread++) hash_packed_chunks(&tasks[thread]);
+    for(thread = 1; thread < created; thread++) pthread_join(threads[thread], NULL);
+    reference_header.checksum = hash_digits((char *) reference_hashes, reference_header.num_chunks * sizeof(uint64_t));
+
+    error = -1;
+    hash_name = malloc(strlen(file_name) + 6);
+    sprintf(hash_name, "%s.hash", file_name);
+    file = fopen(hash_name, "wb");
+    if (file != NULL){
+        error = 0;
+        if (fwrite(&reference_header, sizeof(reference_header), 1, file) != 1) error = -1;
+        if (fwrite(reference_hashes, sizeof(uint64_t), reference_header.num_chunks, file) != reference_header.num_chunks) error = -1;
+        if (fclose(file) != 0) error = -1;
+    }
+
+    //Clear memory
+    free(hash_name);
+    free(threads);
+    free(tasks);
+    free(reference_hashes);
+    reference_hashes = NULL;
+    close_packed(&packed);
+
+    return error;
+}
+
+/*
+ * Loads the hashes of the store of the options and opens its packed file (only the first time)
+ */
+void open_reference(){
+    int correct;
+    char * hash_name;
+    FILE * file;
+
+    if (reference_hashes != NULL) return;
+    hash_name = malloc(strlen(run_options.reference_file) + 6);
+    sprintf(hash_name, "%s.hash", run_options.reference_file);
+    file = fopen(hash_name, "rb");
+    free(hash_name);
+
+    correct = 0;
+    if (file != NULL && fread(&reference_header, sizeof(reference_header), 1, file) == 1 &&
+            reference_header.magic == REFERENCE_MAGIC && reference_header.version == REFERENCE_VERSION &&
+            reference_header.chunk_digits == REFERENCE_CHUNK){
+        reference_hashes = malloc(sizeof(uint64_t) * (reference_header.num_chunks + 1));
+        correct = (fread(reference_hashes, sizeof(uint64_t), reference_header.num_chunks, file) == reference_header.num_chunks &&
+                    hash_digits((char *) reference_hashes, reference_header.num_chunks * sizeof(uint64_t)) == reference_header.checksum);
+    }
+    if (file != NULL) fclose(file);
+    reference_fd = open(run_options.reference_file, O_RDONLY);
+    correct = correct && reference_fd >= 0 &&
+                pread(reference_fd, &reference_packed, sizeof(reference_packed), 0) == sizeof(reference_packed) &&
+                reference_packed.magic == PACKED_MAGIC && reference_packed.base == 10 &&
+                reference_packed.num_digits == reference_header.num_digits;
+    if (!correct){
+        printf("Reference store %s not found or not correct \n", run_options.reference_file);
+        exit(-1);
+    }
+    reference_int_length = sprintf(reference_int, "%lu.", (unsigned long) reference_header.int_part);
+}
+
+/*
+ * Returns the characters of the store ("3." and the decimals)
+ */
+long reference_length(){
+    open_reference();
+    return reference_int_length + reference_header.num_digits;
+}
+
+/*
+ * Reads count characters of the store from the character position in out.
+ * It returns the characters read.
+ */
+long read_reference(long position, long count, char * out){
+    long copied;
+
+    open_reference();
+    for(copied = 0; copied < count && position < reference_int_length; copied++) out[copied] = reference_int[position++];
+    if (copied < count){
+        copied += read_packed_digits(reference_fd, &reference_packed, position - reference_int_length, count - copied, out + copied);
+    }
+    return copied;
+}
+
+/*
+ * Compares count computed decimals with the store from the decimal first, reading them.
+ * It returns the number of decimals that match.
+ */
+long compare_stored_digits(char * computed, long count, long first){
+    long read, matched;
+    char * stored;
+
+    stored = malloc(count);
+    read = read_packed_digits(reference_fd, &reference_packed, first, count, stored);
+    matched = first_mismatch(computed, stored, read, 1);
+    free(stored);
+    return matched;
+}
+
+void * check_chunks(void * arg){
+    long chunk, bad;
+    struct hash_task * task;
+
+    task = (struct hash_task *) arg;
+    for(chunk = task -> begin; chunk < task -> end; chunk++){
+        //An earlier chunk is already wrong
+        if (__atomic_load_n(task -> bad, __ATOMIC_ACQUIRE) < chunk) return NULL;
+        if (hash_digits(task -> computed + chunk * REFERENCE_CHUNK, REFERENCE_CHUNK) !=
+                reference_hashes[task -> first_chunk + chunk]){
+            bad = __atomic_load_n(task -> bad, __ATOMIC_RELAXED);
+            while(chunk < bad && !__atomic_compare_exchange_n(task -> bad, &bad, chunk, 0,
+                                                                __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Returns the first of num_chunks whole chunks of computed decimals (from the chunk
+ * first_chunk of the store) whose hash does not match, or num_chunks.
+ */
+long first_bad_chunk(char * computed, long first_chunk, long num_chunks){
+    int thread, created, num_threads;
+    long bad, part;
+    pthread_t * threads;
+    struct hash_task * tasks;
+
+    bad = num_chunks;
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads > num_chunks) num_threads = num_chunks;
+    if (num_threads < 1) return bad;
+    threads = malloc(sizeof(pthread_t) * num_threads);
+    tasks = malloc(sizeof(struct hash_task) * num_threads);
+    part = num_chunks / num_threads;
+    for(thread = 0; thread < num_threads; thread++){
+        tasks[thread].computed = computed;
+        tasks[thread].first_chunk = first_chunk;
+        tasks[thread].begin = thread * part;
+        tasks[thread].end = (thread == num_threads - 1) ? num_chunks : (thread + 1) * part;
+        tasks[thread].bad = &bad;
+    }
+    created = 1;
+    while(created < num_threads && pthread_create(&threads[created], NULL, check_chunks, &tasks[created]) == 0) created++;
+    check_chunks(&tasks[0]);
+    for(thread = created; thread < num_threads; thread++) check_chunks(&tasks[thread]);
+    for(thread = 1; thread < created; thread++) pthread_join(threads[thread], NULL);
+
+    free(threads);
+    free(tasks);
+    return bad;
+}
+
+/*
+ * Compares length computed characters with the store from the character position
+ * (length must not go past the end of the store). It returns the characters that match.
+ */
+long compare_reference(char * computed, long length, long position){
+    long matched, digit, piece, same, chunk, num_chunks, bad;
+
+    open_reference();
+
+    //Integer part and point
+    for(matched = 0; matched < length && position + matched < reference_int_length; matched++){
+        if (computed[matched] != reference_int[position + matched]) return matched;
+    }
+    digit = position + matched - reference_int_length;
+
+    //Decimals before the first whole chunk
+    piece = (REFERENCE_CHUNK - digit % REFERENCE_CHUNK) % REFERENCE_CHUNK;
+    if (piece > length - matched) piece = length - matched;
+    if (piece > 0){
+        same = compare_stored_digits(computed + matched, piece, digit);
+        if (same < piece) return matched + same;
+        matched += piece;
+        digit += piece;
+    }
+
+    //Whole chunks, by their hashes (the last chunk of the store can be shorter)
+    chunk = digit / REFERENCE_CHUNK;
+    num_chunks = (length - matched) / REFERENCE_CHUNK;
+    bad = first_bad_chunk(computed + matched, chunk, num_chunks);
+    if (bad < num_chunks){
+        return matched + bad * REFERENCE_CHUNK +
+                    compare_stored_digits(computed + matched + bad * REFERENCE_CHUNK, REFERENCE_CHUNK, digit + bad * REFERENCE_CHUNK);
+    }
+    matched += num_chunks * REFERENCE_CHUNK;
+    digit += num_chunks * REFERENCE_CHUNK;
+
+    //Decimals after the last whole chunk
+    piece = length - matched;
+    if (piece > 0) matched += compare_stored_digits(computed + matched, piece, digit);
+
+    return matched;
+}
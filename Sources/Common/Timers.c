@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "../../Headers/Common/Timers.h"
+#include "../../Headers/Common/Trace.h"
+#include "../../Headers/Common/Memory.h"
+#include "../../Headers/Common/Perf.h"
+
+
+/************************************************************************************
+ * Timers of the phases of a run (printed after the results, and saved as JSON      *
+ * with --report file)                                                              *
+ * Every thread adds the time it spends in each phase (monotonic clock) to its own  *
+ * total, and the time of the phase is the total of the slowest thread, as the      *
+ * threads work on the same phase at the same time. In MPI, the time of each phase  *
+ * is the time of the slowest process.                                              *
+ *                                                                                  *
+ * The work of every thread is also recorded (its iterations, the time computing    *
+ * and the time waiting to add its sum), and the imbalance factor is the maximum    *
+ * busy time divided by the mean: 1 means that all the threads finished together.   *
+ * With --trace every phase is also an event of the timeline (see Trace), and with  *
+ * --memory the GMP allocations and operations are counted per phase (see Memory),  *
+ * as the hardware counters with --perf (see Perf).                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+double phase_seconds[NUM_PHASES];
+int phase_generation = 0;                   // Changed by reset_phases and restore_phases
+pthread_mutex_t phase_lock = PTHREAD_MUTEX_INITIALIZER;
+struct thread_work work_threads[MAX_WORK_THREADS];
+int work_num_threads = 0;
+
+__thread double phase_thread_seconds[NUM_PHASES];
+__thread int phase_thread_generation = -1;
+
+char * phase_names[NUM_PHASES] = {"Precision setup", "Initialization", "Series", "Thread reduction",
+                                    "MPI reduction", "Final operations", "Conversion", "Verification"};
+char * phase_keys[NUM_PHASES] = {"setup", "initialization", "series", "thread_reduction",
+                                    "mpi_reduction", "final_operations", "conversion", "verification"};
+
+
+double monotonic_seconds(){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1.e9;
+}
+
+/*
+ * Returns the seconds of the monotonic clock, as the start of a phase
+ * (the hardware counters of the thread are also read with --perf)
+ */
+double phase_clock(){
+    double now;
+
+    now = monotonic_seconds();
+    if (perf_enabled) start_phase_perf(now);
+    return now;
+}
+
+/*
+ * Adds the time since start (got with phase_clock) to the phase for this thread.
+ * It returns the time added.
+ */
+double phase_add(int phase, double start){
+    double elapsed;
+
+    elapsed = monotonic_seconds() - start;
+    if (phase_thread_generation != phase_generation){
+        memset(phase_thread_seconds, 0, sizeof(phase_thread_seconds));
+        phase_thread_generation = phase_generation;
+    }
+    phase_thread_seconds[phase] += elapsed;
+
+    pthread_mutex_lock(&phase_lock);
+    if (phase_thread_seconds[phase] > phase_seconds[phase]) phase_seconds[phase] = phase_thread_seconds[phase];
+    pthread_mutex_unlock(&phase_lock);
+    trace_event(phase_names[phase], start);
+    account_phase_memory(phase);
+    account_phase_perf(phase, start);
+
+    return elapsed;
+}
+
+/*
+ * Starts the timers of a new run (no thread can be measuring a phase)
+ */
+void reset_phases(){
+    memset(phase_seconds, 0, sizeof(phase_seconds));
+    phase_generation++;
+    reset_thread_work();
+    reset_memory_counters();
+    reset_perf_counters();
+}
+
+/*
+ * Copies the times of the phases in saved, to discard with restore_phases the time of
+ * work that is not part of the run (as the calibration of the MPI distributions)
+ */
+void save_phases(double * saved){
+    pthread_mutex_lock(&phase_lock);
+    memcpy(saved, phase_seconds, sizeof(phase_seconds));
+    pthread_mutex_unlock(&phase_lock);
+}
+
+/*
+ * Goes back to the times saved with save_phases. The totals of the threads start again,
+ * so no thread can be measuring a phase.
+ */
+void restore_phases(double * saved){
+    pthread_mutex_lock(&phase_lock);
+    memcpy(phase_seconds, saved, sizeof(phase_seconds));
+    phase_generation++;
+    pthread_mutex_unlock(&phase_lock);
+}
+
+/*
+ * Adds a block of iterations (from first to end, every stride) computed by the thread
+ */
+void record_thread_work(int thread_id, int first, int end, int stride, double busy, double wait){
+    struct thread_work * work;
+
+    if (thread_id < 0 || thread_id >= MAX_WORK_THREADS) return;
+    pthread_mutex_lock(&phase_lock);
+    work = &work_threads[thread_id];
+    if (work -> blocks == 0) work -> first = first;
+    work -> end = end;
+    work -> stride = stride;
+    work -> blocks++;
+    if (end > first) work -> iterations += (end - first + stride - 1) / stride;
+    work -> busy += busy;
+    work -> wait += wait;
+    if (thread_id >= work_num_threads) work_num_threads = thread_id + 1;
+    pthread_mutex_unlock(&phase_lock);
+}
+
+void reset_thread_work(){
+    memset(work_threads, 0, sizeof(work_threads));
+    work_num_threads = 0;
+}
+
+/*
+ * Returns the maximum busy time of the threads divided by the mean
+ */
+double get_imbalance(struct thread_work * threads, int num_threads){
+    int thread;
+    double max, sum;
+
+    max = 0;
+    sum = 0;
+    for(thread = 0; thread < num_threads; thread++){
+        if (threads[thread].busy > max) max = threads[thread].busy;
+        sum += threads[thread].busy;
+    }
+    return (sum > 0) ? max * num_threads / sum : 1;
+}
+
+/*
+ * Prints a line per thread (with the process, if proc_id is not negative)
+ */
+void print_thread_work(struct thread_work * threads, int num_threads, int proc_id){
+    int thread;
+    char range[96];
+
+    for(thread = 0; thread < num_threads; thread++){
+        if (threads[thread].blocks > 1){
+            sprintf(range, "%d-%d (%d blocks)", threads[thread].first, threads[thread].end - 1, threads[thread].blocks);
+        } else {
+            sprintf(range, "%d-%d", threads[thread].first, threads[thread].end - 1);
+        }
+        if (threads[thread].stride > 1) sprintf(range + strlen(range), " every %d", threads[thread].stride);
+        if (proc_id >= 0) printf("      %-7d %-7d", proc_id, thread);
+        else printf("      %-7d", thread);
+        printf(" %-11ld %-32s %-10f %-10f \n", threads[thread].iterations, range, threads[thread].busy, threads[thread].wait);
+    }
+}
+
+/*
+ * Prints the imbalance factor of the threads and, if detailed is not 0, the work of every thread
+ */
+void print_imbalance(int detailed){
+    if (work_num_threads == 0) return;
+    printf("  Load imbalance of the threads (max/mean busy time): %f \n", get_imbalance(work_threads, work_num_threads));
+    if (detailed){
+        printf("      %-7s %-11s %-32s %-10s %-10s \n", "Thread", "Iterations", "Range", "Busy", "Wait");
+        print_thread_work(work_threads, work_num_threads, -1);
+    }
+}
+
+void print_phases(){
+    int phase;
+
+    printf("  Phases (seconds of the slowest thread): \n");
+    for(phase = 0; phase < NUM_PHASES; phase++){
+        if (phase_seconds[phase] > 0) printf("      %-18s %f \n", phase_names[phase], phase_seconds[phase]);
+    }
+}
+
+/*
+ * Saves the properties, results and phases of the run in file_name as JSON
+ */
+void write_run_report(char * file_name, char * version, int algorithm, int precision, int num_iterations,
+                        int num_procs, int num_threads, double execution_time, int decimals){
+    int phase, op, event;
+    char * op_keys[NUM_OPS] = {"mul", "div", "add"};
+    struct memory_counters * counters;
+    FILE * file;
+
+    file = fopen(file_name, "w");
+    if (file == NULL){
+        printf("  Report file %s could not be written \n", file_name);
+        return;
+    }
+    fprintf(file, "{\n  \"version\": \"%s\",\n  \"algorithm\": %d,\n  \"precision\": %d,\n  \"iterations\": %d,\n",
+                version, algorithm, precision, num_iterations);
+    fprintf(file, "  \"processes\": %d,\n  \"threads\": %d,\n  \"execution_time\": %f,\n  \"decimals\": %d,\n",
+                num_procs, num_threads, execution_time, decimals);
+    fprintf(file, "  \"phases\": {\n");
+    for(phase = 0; phase < NUM_PHASES; phase++){
+        fprintf(file, "    \"%s\": %f%s\n", phase_keys[phase], phase_seconds[phase], (phase < NUM_PHASES - 1) ? "," : "");
+    }
+    fprintf(file, "  }");
+
+    //GMP memory and operations of every phase and in total (--memory)
+    if (memory_enabled){
+        fprintf(file, ",\n  \"memory\": {\n");
+        for(phase = 0; phase <= NUM_PHASES; phase++){
+            counters = (phase < NUM_PHASES) ? &memory_phases[phase] : &memory_total;
+            fprintf(file, "    \"%s\": {\"allocations\": %ld, \"reallocations\": %ld, \"frees\": %ld, \"bytes\": %ld, \"peak_bytes\": %ld",
+                        (phase < NUM_PHASES) ? phase_keys[phase] : "total", counters -> allocations, counters -> reallocations, 
+                        counters -> frees, counters -> bytes, counters -> peak);
+            for(op = 0; op < NUM_OPS && memory_ops_counted; op++) fprintf(file, ", \"%s\": %ld", op_keys[op], counters -> ops[op]);
+            fprintf(file, "}%s\n", (phase < NUM_PHASES) ? "," : "");
+        }
+        fprintf(file, "  }");
+    }
+
+    //Hardware counters of every phase and in total (--perf)
+    if (perf_enabled){
+        fprintf(file, ",\n  \"perf\": {\n");
+        for(phase = 0; phase <= NUM_PHASES; phase++){
+            fprintf(file, "    \"%s\": {", (phase < NUM_PHASES) ? phase_keys[phase] : "total");
+            for(event = 0; event < NUM_PERF_EVENTS; event++){
+                fprintf(file, "%s\"%s\": ", (event > 0) ? ", " : "", perf_keys[event]);
+                if (!perf_available[event]) fprintf(file, "null");
+                else fprintf(file, "%ld", (phase < NUM_PHASES) ? perf_phases[phase].values[event] : perf_total.values[event]);
+            }
+            fprintf(file, "}%s\n", (phase < NUM_PHASES) ? "," : "");
+        }
+        fprintf(file, "  }");
+    }
+    fprintf(file, "\n}\n");
+    fclose(file);
+}
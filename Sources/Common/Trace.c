@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../Headers/Common/Timers.h"
+#include "../../Headers/Common/Trace.h"
+
+
+/************************************************************************************
+ * Timeline of the run (--trace file)                                               *
+ * Every thread records its events (each timed phase: the blocks of the series, the *
+ * seeds, the reductions, the final operations... the MPI pack and unpack and the   *
+ * fixed point convert and restore) in its own ring of TRACE_EVENTS events, so      *
+ * recording an event takes no lock. The rings are registered with an atomic        *
+ * counter the first time a thread records.                                         *
+ *                                                                                  *
+ * At the end the events are saved in the Trace Event Format of Chrome (also read   *
+ * by Perfetto), as complete events ("ph": "X") with the process and the thread:    *
+ * chrome://tracing or ui.perfetto.dev show where the threads were idle. In MPI,    *
+ * the clock of every process is corrected with its offset to the clock of process  *
+ * 0 (see TraceMPI).                                                                *
+ *                                                                                  *
+ ************************************************************************************/
+
+struct trace_ring {
+    struct trace_event events[TRACE_EVENTS];
+    unsigned long head;                     // Events recorded (only moved by its thread)
+};
+
+int trace_enabled = 0;
+struct trace_ring * trace_rings[MAX_TRACE_THREADS];
+int trace_num_rings = 0;
+
+__thread struct trace_ring * trace_local = NULL;
+__thread int trace_thread = -1;
+
+
+void start_trace(){
+    trace_enabled = 1;
+}
+
+/*
+ * Records an event from start (got with phase_clock) until now in the ring of this thread
+ */
+void trace_event(char * name, double start){
+    double end;
+    struct trace_event * event;
+
+    if (!trace_enabled) return;
+    end = phase_clock();
+
+    //First event of the thread: its ring is registered
+    if (trace_local == NULL){
+        if (trace_thread >= 0) return;
+        trace_thread = __atomic_fetch_add(&trace_num_rings, 1, __ATOMIC_ACQ_REL);
+        if (trace_thread >= MAX_TRACE_THREADS) return;
+        trace_local = calloc(1, sizeof(struct trace_ring));
+        __atomic_store_n(&trace_rings[trace_thread], trace_local, __ATOMIC_RELEASE);
+    }
+
+    event = &trace_local -> events[trace_local -> head % TRACE_EVENTS];
+    strncpy(event -> name, name, TRACE_NAME - 1);
+    event -> thread = trace_thread;
+    event -> start = start;
+    event -> duration = end - start;
+    __atomic_store_n(&trace_local -> head, trace_local -> head + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Copies the events of all the threads (in the heap) with the process and the start 
+ * minus offset. It must be called when the threads are not recording.
+ * It returns the number of events.
+ */
+long collect_trace(struct trace_event ** events, int process, double offset){
+    int ring, num_rings;
+    long num_events, first, count, i;
+    unsigned long head;
+    struct trace_event * event;
+
+    num_rings = __atomic_load_n(&trace_num_rings, __ATOMIC_ACQUIRE);
+    if (num_rings > MAX_TRACE_THREADS) num_rings = MAX_TRACE_THREADS;
+    num_events = 0;
+    for(ring = 0; ring < num_rings; ring++){
+        if (trace_rings[ring] == NULL) continue;
+        head = __atomic_load_n(&trace_rings[ring] -> head, __ATOMIC_ACQUIRE);
+        num_events += (head < TRACE_EVENTS) ? head : TRACE_EVENTS;
+    }
+
+    *events = malloc(sizeof(struct trace_event) * (num_events + 1));
+    num_events = 0;
+    for(ring = 0; ring < num_rings; ring++){
+        if (trace_rings[ring] == NULL) continue;
+        head = __atomic_load_n(&trace_rings[ring] -> head, __ATOMIC_ACQUIRE);
+        first = (head < TRACE_EVENTS) ? 0 : head - TRACE_EVENTS;
+        count = head - first;
+        if (first > 0) printf("  Trace: the first %ld events of thread %d were overwritten \n", first, ring);
+        for(i = 0; i < count; i++){
+            event = &(*events)[num_events++];
+            *event = trace_rings[ring] -> events[(first + i) % TRACE_EVENTS];
+            event -> process = process;
+            event -> start -= offset;
+        }
+    }
+    return num_events;
+}
+
+/*
+ * Saves the events as Chrome Trace Event JSON, with the times in microseconds 
+ * since the first event. It returns 0, or -1 if the file could not be written.
+ */
+int write_trace(char * file_name, struct trace_event * events, long num_events){
+    long i;
+    int last_process, last_thread;
+    double origin;
+    FILE * file;
+
+    file = fopen(file_name, "w");
+    if (file == NULL) return -1;
+
+    origin = 0;
+    for(i = 0; i < num_events; i++){
+        if (i == 0 || events[i].start < origin) origin = events[i].start;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    last_process = -1;
+    last_thread = -1;
+    for(i = 0; i < num_events; i++){
+        //Names of the process and the thread of the next events (they are grouped)
+        if (events[i].process != last_process){
+            fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"Process %d\"}},\n",
+                        events[i].process, events[i].process);
+        }
+        if (events[i].process != last_process || events[i].thread != last_thread){
+            fprintf(file, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"Thread %d\"}},\n",
+                        events[i].process, events[i].thread, events[i].thread);
+        }
+        last_process = events[i].process;
+        last_thread = events[i].thread;
+        fprintf(file, "{\"name\": \"%s\", \"cat\": \"pi\", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}%s\n",
+                    events[i].name, events[i].process, events[i].thread, (events[i].start - origin) * 1.e6, 
+                    events[i].duration * 1.e6, (i < num_events - 1) ? "," : "");
+    }
+    fprintf(file, "]}\n");
+
+    return (fclose(file) == 0) ? 0 : -1;
+}
+
+/*
+ * Saves the events of this process in file_name (see write_trace)
+ */
+void save_trace(char * file_name){
+    long num_events;
+    struct trace_event * events;
+
+    num_events = collect_trace(&events, 0, 0);
+    if (write_trace(file_name, events, num_events) == 0){
+        printf("  Trace of %ld events written to %s \n", num_events, file_name);
+    } else {
+        printf("  Trace file %s could not be written \n", file_name);
+    }
+    free(events);
+}
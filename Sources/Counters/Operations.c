@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <gmp.h>
+#include "../../Headers/Common/Timers.h"
+#include "../../Headers/Common/Memory.h"
+
+
+/************************************************************************************
+ * Counters of the mpf operations (--memory)                                        *
+ * The calls to mpf mul, div and add (or sub) are counted with the wrappers of the  *
+ * linker. This file is only built with the -Wl,--wrap flags of the same functions  *
+ * (./compile.sh program counters), so the other builds do not depend on them.      *
+ *                                                                                  *
+ ************************************************************************************/
+
+int memory_ops_counted = 1;
+
+void __real___gmpf_mul(mpf_ptr, mpf_srcptr, mpf_srcptr);
+void __real___gmpf_mul_ui(mpf_ptr, mpf_srcptr, unsigned long);
+void __real___gmpf_div(mpf_ptr, mpf_srcptr, mpf_srcptr);
+void __real___gmpf_div_ui(mpf_ptr, mpf_srcptr, unsigned long);
+void __real___gmpf_add(mpf_ptr, mpf_srcptr, mpf_srcptr);
+void __real___gmpf_add_ui(mpf_ptr, mpf_srcptr, unsigned long);
+void __real___gmpf_sub(mpf_ptr, mpf_srcptr, mpf_srcptr);
+
+
+void __wrap___gmpf_mul(mpf_ptr r, mpf_srcptr a, mpf_srcptr b){
+    count_op(OP_MUL);
+    __real___gmpf_mul(r, a, b);
+}
+
+void __wrap___gmpf_mul_ui(mpf_ptr r, mpf_srcptr a, unsigned long b){
+    count_op(OP_MUL);
+    __real___gmpf_mul_ui(r, a, b);
+}
+
+void __wrap___gmpf_div(mpf_ptr r, mpf_srcptr a, mpf_srcptr b){
+    count_op(OP_DIV);
+    __real___gmpf_div(r, a, b);
+}
+
+void __wrap___gmpf_div_ui(mpf_ptr r, mpf_srcptr a, unsigned long b){
+    count_op(OP_DIV);
+    __real___gmpf_div_ui(r, a, b);
+}
+
+void __wrap___gmpf_add(mpf_ptr r, mpf_srcptr a, mpf_srcptr b){
+    count_op(OP_ADD);
+    __real___gmpf_add(r, a, b);
+}
+
+void __wrap___gmpf_add_ui(mpf_ptr r, mpf_srcptr a, unsigned long b){
+    count_op(OP_ADD);
+    __real___gmpf_add_ui(r, a, b);
+}
+
+void __wrap___gmpf_sub(mpf_ptr r, mpf_srcptr a, mpf_srcptr b){
+    count_op(OP_ADD);
+    __real___gmpf_sub(r, a, b);
+}
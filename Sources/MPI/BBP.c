@@ -6,6 +6,12 @@
 #include "mpi.h"
 #include "../../Headers/Sequential/BBP.h"
 #include "../../Headers/MPI/OperationsMPI.h"
+#include "../../Headers/MPI/OverlapMPI.h"
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/MPI/DistributionMPI.h"
+#include "../../Headers/Common/Checkpoint.h"
+#include "../../Headers/MPI/CheckpointMPI.h"
+#include "../../Headers/Common/Timers.h"
 
 
 #define QUOTIENT 0.0625
@@ -43,87 +49,112 @@
 
 
 /*
- * Parallel Pi number calculation using the BBP algorithm
- * Multiple procs and threads can be used
- * The number of iterations is divided by blocks, 
- * so each process calculates a part of pi using threads. 
- * Each process will cyclically divide the iterations 
- * among the threads to calculate its part.  
- * Finally, a collective reduction operation will be performed
- * using a user defined function in OperationsMPI. 
+ * Computes the BBP iterations next, next + stride, ... before end and adds them to sum.
+ * Its state is saved in the checkpoint slot (if it is not -1).
  */
-void BBP_algorithm_MPI(int num_procs, int proc_id, mpf_t pi, 
-                            int num_iterations, int num_threads){
-    int block_size, block_start, block_end, position, packet_size;
-    mpf_t local_proc_pi, jump, quotient;
+void BBP_progression_MPI(mpf_t sum, int slot, int next, int stride, int end){
+    int i;
+    mpf_t jump, quotient, dep_m, quot_a, quot_b, quot_c, quot_d, aux;
 
-    block_size = (num_iterations + num_procs - 1) / num_procs;
-    block_start = proc_id * block_size;
-    block_end = block_start + block_size;
-    if (block_end > num_iterations) block_end = num_iterations;
-
-    mpf_init_set_ui(local_proc_pi, 0);          
     mpf_init_set_d(quotient, QUOTIENT);             // quotient = (1 / 16)   
-    mpf_init_set_ui(jump, 1);        
-    mpf_pow_ui(jump, quotient, num_threads);        // jump = (1/16)^num_threads
-    
+    mpf_init(jump);        
+    mpf_pow_ui(jump, quotient, stride);             // jump = (1/16)^stride
+    mpf_init(dep_m);      
+    mpf_pow_ui(dep_m, quotient, next);              // dep_m = (1/16)^n      
+    mpf_inits(quot_a, quot_b, quot_c, quot_d, aux, NULL);    
+    mpf_ptr state[] = {sum};
+
+    for(i = next; i < end; i += stride){    
+        checkpoint_poll(slot, i, state);
+        BBP_iteration(sum, i, dep_m, quot_a, quot_b, quot_c, quot_d, aux); 
+        // Update depencies: 
+        mpf_mul(dep_m, dep_m, jump);    
+    }
+    checkpoint_done(slot, state);
+
+    //Clear memory
+    mpf_clears(quotient, jump, dep_m, quot_a, quot_b, quot_c, quot_d, aux, NULL);
+}
+
+/*
+ * Computes the BBP iterations from block_start to block_end (not included) 
+ * and adds them to local_proc_pi. The iterations of the block are 
+ * divided cyclically among the threads.
+ */
+void BBP_block_MPI(mpf_t local_proc_pi, int block_start, int block_end, int num_threads){
     //Set the number of threads 
     omp_set_num_threads(num_threads);
 
     #pragma omp parallel
     {
-        int thread_id, i;
-        mpf_t local_thread_pi, dep_m, quot_a, quot_b, quot_c, quot_d, aux;
+        int thread_id, slot;
+        double start, busy, wait;
+        mpf_t local_thread_pi;
 
         thread_id = omp_get_thread_num();
         mpf_init_set_ui(local_thread_pi, 0);                    // private thread pi
-        mpf_init(dep_m);      
-        mpf_pow_ui(dep_m, quotient, block_start + thread_id);   // dep_m = (1/16)^n      
-        mpf_inits(quot_a, quot_b, quot_c, quot_d, aux, NULL);    
 
         //First Phase -> Working on a local variable        
-        #pragma omp parallel for 
-            for(i = block_start + thread_id; i < block_end; i+=num_threads){    
-                BBP_iteration(local_thread_pi, i, dep_m, quot_a, quot_b, quot_c, quot_d, aux); 
-                // Update depencies: 
-                mpf_mul(dep_m, dep_m, jump);    
-            }
+        start = phase_clock();
+        slot = open_checkpoint_slot(block_start + thread_id, num_threads, block_start + thread_id, block_end, NULL);
+        BBP_progression_MPI(local_thread_pi, slot, block_start + thread_id, num_threads, block_end);
+        busy = phase_add(PHASE_SERIES, start);
 
         //Second Phase -> Accumulate the result in the global variable
-        #pragma omp critical
-        mpf_add(local_proc_pi, local_proc_pi, local_thread_pi);
+        //(or start its reduction among the processes in overlap mode)
+        start = phase_clock();
+        if (reduce_thread_pi_MPI(thread_id, local_thread_pi) != 0){
+            #pragma omp critical
+            mpf_add(local_proc_pi, local_proc_pi, local_thread_pi);
+        }
+        wait = phase_add(PHASE_THREAD_REDUCTION, start);
+        record_thread_work(thread_id, block_start + thread_id, block_end, num_threads, busy, wait);
 
         //Clear memory
-        mpf_clears(local_thread_pi, dep_m, quot_a, quot_b, quot_c, quot_d, aux, NULL);
+        mpf_clear(local_thread_pi);
     }
+}
 
+/*
+ * Parallel Pi number calculation using the BBP algorithm
+ * Multiple procs and threads can be used
+ * The number of iterations is divided by blocks 
+ * (equal, weighted by throughput or dynamic, see DistributionMPI), 
+ * so each process calculates a part of pi using threads. 
+ * Each process will cyclically divide the iterations 
+ * among the threads to calculate its part.  
+ * Finally, a reduction of the partial sums will be performed
+ * using reduce_sum in OperationsMPI (reduce_sum_shm with --shm; with 
+ * --overlap, the partial sum of each thread is reduced as soon as it 
+ * finishes, see OverlapMPI). 
+ * With --checkpoint, every process saves the progressions of its threads,
+ * so a failed run can be restarted with --resume (see CheckpointMPI).
+ */
+void BBP_algorithm_MPI(int num_procs, int proc_id, mpf_t pi, 
+                            int num_iterations, int num_threads){
+    int block[3];
+    double start;
+    mpf_t local_proc_pi;
 
-    //Create user defined operation
-    MPI_Op add_op;
-    MPI_Op_create((MPI_User_function *)add, 0, &add_op);
-
-    //Set buffers for cumunications, and position for pack and unpack information 
-    packet_size = 8 + sizeof(mp_exp_t) + ((local_proc_pi -> _mp_prec + 1) * sizeof(mp_limb_t));
-    char recbuffer[packet_size];
-    char sendbuffer[packet_size];
-
-
-    //Pack local_proc_pi in sendbuffuer
-    position = pack(sendbuffer, local_proc_pi);
-
-    //Reduce piLocal
-    MPI_Reduce(sendbuffer, recbuffer, position, MPI_PACKED, add_op, 0, MPI_COMM_WORLD);
-
-    //Unpack recbuffer in global Pi
-    if (proc_id == 0){
-        unpack(recbuffer, pi);
+    mpf_init_set_ui(local_proc_pi, 0);          
+    if (restart_MPI(num_procs, proc_id, local_proc_pi, CHECKPOINT_BBP, num_iterations, 
+                        num_threads, BBP_progression_MPI) != 0){
+        get_process_block(num_procs, proc_id, num_iterations, num_threads, BBP_block_MPI, block);
+        init_checkpoint_MPI(num_procs, proc_id, CHECKPOINT_BBP, num_iterations, num_threads * get_max_blocks(num_procs));
+
+        init_overlap_MPI(num_threads);
+        BBP_block_MPI(local_proc_pi, block[0], block[1], num_threads);
+        compute_dynamic_blocks(local_proc_pi, block[2], num_iterations, num_procs, num_threads, BBP_block_MPI);
     }
+    finish_checkpoint();
 
+    //Reduce local_proc_pi in global Pi
+    start = phase_clock();
+    if (run_options.shm) reduce_sum_shm(pi, local_proc_pi, MPI_COMM_WORLD);
+    else reduce_sum(pi, local_proc_pi, MPI_COMM_WORLD);
+    finish_overlap_MPI(pi, proc_id);
+    phase_add(PHASE_MPI_REDUCTION, start);
 
     //Clear memory
-    MPI_Op_free(&add_op);
-    mpf_clears(local_proc_pi, quotient, jump, NULL);
+    mpf_clear(local_proc_pi);
 }
-
-
-
@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gmp.h>
+#include <omp.h>
+#include "mpi.h"
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/Common/Checkpoint.h"
+
+
+/************************************************************************************
+ * Checkpoints of the MPI algorithms (--checkpoint file, --resume)                  *
+ * Each process saves its own checkpoint (file.proc_id) with a slot for every       *
+ * progression of iterations done by its threads (see Checkpoint) and its partial   *
+ * sum, so the sum of all the slots of all the processes is local_proc_pi.          *
+ * The dependencies are not saved, as they can be computed from the next iteration. *
+ *                                                                                  *
+ * When a run is restarted, every process reads the checkpoints of all the          *
+ * processes of the previous run (file.0 tells how many they were), and the         *
+ * progressions are distributed among the new processes (there can be a different  *
+ * number of them) to compute only the iterations that are left. The iterations    *
+ * that were not in any progression (chunks of the dynamic distribution not taken  *
+ * yet) are added as new progressions.                                              *
+ * The new processes save their progressions before computing them, with the next   *
+ * generation of the run, so the run can be restarted again.                        *
+ *                                                                                  *
+ ************************************************************************************/
+
+char * checkpoint_name_MPI = NULL;
+
+
+/*
+ * Checkpoint file of a process: file.proc_id
+ */
+char * get_checkpoint_name_MPI(int proc_id){
+    char * name;
+
+    name = malloc(strlen(run_options.checkpoint_file) + 16);
+    sprintf(name, "%s.%d", run_options.checkpoint_file, proc_id);
+    return name;
+}
+
+/*
+ * Starts the checkpoints of this process, with up to max_slots progressions and
+ * their partial sums. It does nothing if no checkpoint file is given.
+ * The writer does not wait for every slot: the iterations of the progressions that
+ * are not in the checkpoint are computed again when it is resumed.
+ */
+void init_checkpoint_generation_MPI(int num_procs, int proc_id, int algorithm, int num_iterations,
+                                        int max_slots, int generation){
+    if (run_options.checkpoint_file == NULL) return;
+
+    free(checkpoint_name_MPI);
+    checkpoint_name_MPI = get_checkpoint_name_MPI(proc_id);
+    init_checkpoint_file(checkpoint_name_MPI, algorithm, num_iterations, max_slots, 0, 1, num_procs, generation);
+}
+
+void init_checkpoint_MPI(int num_procs, int proc_id, int algorithm, int num_iterations, int max_slots){
+    init_checkpoint_generation_MPI(num_procs, proc_id, algorithm, num_iterations, max_slots, 0);
+}
+
+void incorrect_checkpoint_MPI(int proc_id, char * message, char * file_name){
+    if (proc_id == 0) printf("  Checkpoint %s %s \n\n", file_name, message);
+    MPI_Finalize();
+    exit(-1);
+}
+
+/*
+ * Reads the checkpoints of all the processes of the previous run.
+ * It returns the number of progressions (stored in slots), or -1 if there is no checkpoint.
+ */
+int read_checkpoints_MPI(int proc_id, int algorithm, int num_iterations,
+                            struct checkpoint_slot ** slots, int * generation){
+    int p, num_slots, old_procs;
+    char * name;
+    struct checkpoint_header header;
+    struct checkpoint_slot * file_slots;
+
+    num_slots = 0;
+    old_procs = 1;
+    *slots = NULL;
+    for(p = 0; p < old_procs; p++){
+        name = get_checkpoint_name_MPI(p);
+        if (read_checkpoint(name, &header, &file_slots) != 0){
+            if (p == 0){
+                free(name);
+                return -1;
+            }
+            incorrect_checkpoint_MPI(proc_id, "not found (the checkpoint of the run is not complete)", name);
+        }
+        if (p == 0){
+            old_procs = header.processes;
+            *generation = header.generation;
+        }
+        if (header.algorithm != algorithm || header.precision != (int) mpf_get_default_prec() ||
+                    header.iterations != num_iterations || header.values != 1){
+            incorrect_checkpoint_MPI(proc_id, "was written with other algorithm or precision", name);
+        }
+        if (header.processes != old_procs || header.generation != *generation){
+            incorrect_checkpoint_MPI(proc_id, "is from other generation of the run", name);
+        }
+
+        *slots = realloc(*slots, sizeof(struct checkpoint_slot) * (num_slots + header.slots));
+        memcpy(*slots + num_slots, file_slots, sizeof(struct checkpoint_slot) * header.slots);
+        num_slots += header.slots;
+        free(file_slots);
+        free(name);
+    }
+
+    return num_slots;
+}
+
+/*
+ * Adds the iterations that are not in any progression as new progressions,
+ * in pieces of at most piece_size iterations.
+ */
+int add_missing_progressions_MPI(struct checkpoint_slot ** slots, int num_slots, int num_iterations, int piece_size){
+    int i, s, start;
+    char * covered;
+    struct checkpoint_slot * current;
+
+    covered = calloc(num_iterations, sizeof(char));
+    for(s = 0; s < num_slots; s++){
+        current = &(*slots)[s];
+        for(i = current -> first; i < current -> end; i += current -> stride) covered[i] = 1;
+    }
+
+    i = 0;
+    while(i < num_iterations){
+        if (covered[i]){
+            i++;
+            continue;
+        }
+        start = i;
+        while(i < num_iterations && !covered[i] && i - start < piece_size) i++;
+
+        *slots = realloc(*slots, sizeof(struct checkpoint_slot) * (num_slots + 1));
+        current = &(*slots)[num_slots++];
+        current -> first = start;
+        current -> stride = 1;
+        current -> next = start;
+        current -> end = i;
+        current -> values = malloc(sizeof(mpf_t));
+        mpf_init_set_ui(current -> values[0], 0);
+    }
+
+    free(covered);
+    return num_slots;
+}
+
+/*
+ * Restarts the run from the checkpoints of a previous one (with --resume).
+ * The progressions are given to the processes with less iterations left, in order,
+ * and the threads of each process compute them with compute_progression
+ * (partial sum, checkpoint slot, next iteration, stride, end).
+ * It returns -1 if the run is not restarted, so it must be computed as usual.
+ * IMPORTANT: It must be called by every process
+ */
+int restart_MPI(int num_procs, int proc_id, mpf_t local_proc_pi, int algorithm, int num_iterations,
+                    int num_threads, void (*compute_progression)(mpf_t, int, int, int, int)){
+    int s, p, num_slots, owner, generation, total_threads, piece_size, num_own, * own, * own_slots;
+    long left, * load;
+    struct checkpoint_slot * slots, * current;
+
+    if (run_options.checkpoint_file == NULL || !run_options.resume) return -1;
+
+    num_slots = read_checkpoints_MPI(proc_id, algorithm, num_iterations, &slots, &generation);
+    if (num_slots < 0){
+        if (proc_id == 0) printf("  Checkpoint %s.0 not found, starting from the first iteration \n", run_options.checkpoint_file);
+        return -1;
+    }
+    MPI_Allreduce(&num_threads, &total_threads, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    piece_size = num_iterations / total_threads;
+    if (piece_size < 1) piece_size = 1;
+    num_slots = add_missing_progressions_MPI(&slots, num_slots, num_iterations, piece_size);
+
+    //The progressions are given to the processes with less iterations left
+    load = calloc(num_procs, sizeof(long));
+    own = malloc(sizeof(int) * (num_slots + 1));
+    num_own = 0;
+    for(s = 0; s < num_slots; s++){
+        current = &slots[s];
+        left = (current -> end > current -> next) ? (current -> end - current -> next + current -> stride - 1) / current -> stride : 0;
+        owner = 0;
+        for(p = 1; p < num_procs; p++){
+            if (load[p] < load[owner]) owner = p;
+        }
+        load[owner] += left;
+        if (owner == proc_id) own[num_own++] = s;
+    }
+    if (proc_id == 0){
+        for(p = 1; p < num_procs; p++) load[0] += load[p];
+        printf("  Restarting from checkpoint %s (%d progressions, %ld iterations left) \n",
+                    run_options.checkpoint_file, num_slots, load[0]);
+    }
+
+    //Every process has read the old checkpoints before the new ones are saved
+    MPI_Barrier(MPI_COMM_WORLD);
+    init_checkpoint_generation_MPI(num_procs, proc_id, algorithm, num_iterations, num_own, generation + 1);
+    own_slots = malloc(sizeof(int) * (num_own + 1));
+    for(s = 0; s < num_own; s++){
+        current = &slots[own[s]];
+        mpf_ptr state[] = {current -> values[0]};
+        own_slots[s] = open_checkpoint_slot(current -> first, current -> stride, current -> next,
+                                                current -> end, state);
+        checkpoint_idle(own_slots[s], 1);
+    }
+    save_checkpoint();
+
+    //Set the number of threads
+    omp_set_num_threads(num_threads);
+
+    #pragma omp parallel for schedule(dynamic)
+        for(s = 0; s < num_own; s++){
+            struct checkpoint_slot * progression = &slots[own[s]];
+            checkpoint_idle(own_slots[s], 0);
+            compute_progression(progression -> values[0], own_slots[s], progression -> next, 
+                                    progression -> stride, progression -> end);
+            #pragma omp critical
+            mpf_add(local_proc_pi, local_proc_pi, progression -> values[0]);
+        }
+
+    //Clear memory
+    clear_checkpoint_slots(slots, num_slots, 1);
+    free(load);
+    free(own);
+    free(own_slots);
+
+    return 0;
+}
@@ -5,6 +5,11 @@
 #include "mpi.h"
 #include "../../Headers/Sequential/Chudnovsky.h"
 #include "../../Headers/MPI/OperationsMPI.h"
+#include "../../Headers/MPI/OverlapMPI.h"
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/Common/Checkpoint.h"
+#include "../../Headers/MPI/CheckpointMPI.h"
+#include "../../Headers/Common/Timers.h"
 
 #define A 13591409
 #define B 545140134
@@ -43,94 +48,196 @@
 
 
 /*
- * This method provides an optimal distribution for each thread of any proc
- * based on the Chudnovsky iterations analysis.
- * IMPORTANT: The number of threads used MUST be the same in every process
- * IMPORTANT: (num_procs * num_threads) % 4 == 0 OR (num_procs * num_threads) == 2
+ * This method provides the distribution for each thread of any proc.
+ * The iterations are divided in blocks of the same size (+-1) among all the threads 
+ * of all the procs, ordered by process and then by thread. 
+ * The processes can use a different number of threads, so the thread is identified 
+ * by worker_id = (threads of the previous processes) + thread_id.
  * It returns an array of three integers:
  *   distribution[0] -> block size
  *   distribution[1] -> block start
  *   distribution[2] -> block end 
  */
-int * get_distribution(int num_procs, int proc_id, int num_threads, int thread_id, int num_iterations){
-    int * distribution, i, block_size, block_start, block_end, my_row, my_column, row, column;
-    FILE * ratios_file;
-    float working_ratios[160][41], my_working_ratio;
-
-    //Open the working_ratios file 
-    ratios_file = fopen("Resources/working_ratios.txt", "r");
-    if(ratios_file == NULL){
-        printf("working_ratios.txt not found \n");
-        MPI_Finalize();
-        exit(-1);
-    } 
-
-    //Load the working_ratios matrix 
-    row = 0;
-    while (fscanf(ratios_file, "%f", &working_ratios[row][0]) == 1){
-        for (column = 1; column < 41; column++){
-            fscanf(ratios_file, "%f", &working_ratios[row][column]);
-        }
-        row++;
-    }
+int * get_distribution(int total_threads, int worker_id, int num_iterations){
+    int * distribution, block_start, block_end;
+
+    block_start = ((long) num_iterations * worker_id) / total_threads;
+    block_end = ((long) num_iterations * (worker_id + 1)) / total_threads;
 
     distribution = malloc(sizeof(int) * 3);
-    if(num_threads * num_procs == 1){
-        distribution[0] = num_iterations;
-        distribution[1] = 0;
-        distribution[2] = num_iterations;
-        return distribution; 
-    }
+    distribution[0] = block_end - block_start;
+    distribution[1] = block_start;    
+    distribution[2] = block_end;    
 
-    my_row = (num_threads * proc_id) + thread_id;
-    my_column = (num_procs * num_threads) / 4;
-    my_working_ratio = working_ratios[my_row][my_column];
+    return distribution;
+}
 
-    block_size = my_working_ratio * num_iterations / 100;
-    block_start = 0;
-    for(i = 0; i < my_row; i ++){
-        block_start += working_ratios[i][my_column] * num_iterations / 100;
+
+/*
+ * This method is used by ParallelChudnovskyAlgorithm threads
+ * for computing the first values of dep_a and dep_b of their blocks.
+ * Each thread computes the ratios of its own block, then a parallel prefix product
+ * is done among the threads of the process and an exclusive scan among the processes:
+ *      dep_a(block_start) = PRODUCT( dep_a(block_end) / dep_a(block_start) ), previous blocks
+ *      dep_b(block_start) = PRODUCT( c^(block_end - block_start) ),           previous blocks
+ * so no thread repeats the factorial work of the previous blocks.
+ * IMPORTANT: It must be called by every thread of the parallel region
+ */
+void init_block_seeds_MPI(mpf_t dep_a, mpf_t dep_b, mpf_t c, int block_start, int block_end){
+    int thread_id, num_threads, step, current, next, proc_id, packet_size;
+    mpf_t * scan_a, * scan_b;
+    char * recbuffer, * sendbuffer;
+    MPI_Op mul_op;
+
+    thread_id = omp_get_thread_num();
+    num_threads = omp_get_num_threads();
+
+    //Two buffers of num_threads values for the prefix products of dep_a and dep_b
+    //and a last position for the product of the previous processes
+    #pragma omp single copyprivate(scan_a, scan_b)
+    {
+        scan_a = malloc(sizeof(mpf_t) * (2 * num_threads + 1));
+        scan_b = malloc(sizeof(mpf_t) * (2 * num_threads + 1));
     }
-    block_end = block_start + block_size;
 
-    if (thread_id == (num_threads - 1) && proc_id == (num_procs - 1)){ 
-        //If Last thread from last process:
-        block_end = num_iterations;
-        block_size = block_end - block_start;
+    mpf_inits(scan_a[thread_id], scan_a[num_threads + thread_id], NULL);
+    mpf_inits(scan_b[thread_id], scan_b[num_threads + thread_id], NULL);
+    get_dep_a_ratio(scan_a[thread_id], block_start, block_end);
+    mpf_pow_ui(scan_b[thread_id], c, block_end - block_start);
+    #pragma omp barrier
+
+    //Inclusive prefix product among the threads in log2(num_threads) steps
+    current = 0;
+    for(step = 1; step < num_threads; step <<= 1){
+        next = num_threads - current;
+        if (thread_id >= step){
+            mpf_mul(scan_a[next + thread_id], scan_a[current + thread_id - step], scan_a[current + thread_id]);
+            mpf_mul(scan_b[next + thread_id], scan_b[current + thread_id - step], scan_b[current + thread_id]);
+        } else {
+            mpf_set(scan_a[next + thread_id], scan_a[current + thread_id]);
+            mpf_set(scan_b[next + thread_id], scan_b[current + thread_id]);
+        }
+        current = next;
+        #pragma omp barrier
     }
 
-    distribution[0] = block_size;
-    distribution[1] = block_start;    
-    distribution[2] = block_end;    
+    //Exclusive prefix product among the processes
+    #pragma omp master
+    {
+        MPI_Comm_rank(MPI_COMM_WORLD, &proc_id);
+        MPI_Op_create((MPI_User_function *)mul, 1, &mul_op);
+        mpf_init(scan_a[2 * num_threads]);
+        mpf_init(scan_b[2 * num_threads]);
+        packet_size = 8 + sizeof(mp_exp_t) + ((scan_a[2 * num_threads] -> _mp_prec + 1) * sizeof(mp_limb_t));
+        recbuffer = malloc(packet_size);
+        sendbuffer = malloc(packet_size);
+
+        pack(sendbuffer, scan_a[current + num_threads - 1]);
+        MPI_Exscan(sendbuffer, recbuffer, packet_size, MPI_PACKED, mul_op, MPI_COMM_WORLD);
+        if (proc_id == 0) mpf_set_ui(scan_a[2 * num_threads], 1);
+        else unpack(recbuffer, scan_a[2 * num_threads]);
+
+        pack(sendbuffer, scan_b[current + num_threads - 1]);
+        MPI_Exscan(sendbuffer, recbuffer, packet_size, MPI_PACKED, mul_op, MPI_COMM_WORLD);
+        if (proc_id == 0) mpf_set_ui(scan_b[2 * num_threads], 1);
+        else unpack(recbuffer, scan_b[2 * num_threads]);
+
+        MPI_Op_free(&mul_op);
+        free(recbuffer);
+        free(sendbuffer);
+    }
+    #pragma omp barrier
+
+    //The seed of each block is the product of the previous blocks
+    if (thread_id == 0){
+        mpf_set(dep_a, scan_a[2 * num_threads]);
+        mpf_set(dep_b, scan_b[2 * num_threads]);
+    } else {
+        mpf_mul(dep_a, scan_a[2 * num_threads], scan_a[current + thread_id - 1]);
+        mpf_mul(dep_b, scan_b[2 * num_threads], scan_b[current + thread_id - 1]);
+    }
+    #pragma omp barrier
 
-    return distribution;
-}
+    mpf_clears(scan_a[thread_id], scan_a[num_threads + thread_id], NULL);
+    mpf_clears(scan_b[thread_id], scan_b[num_threads + thread_id], NULL);
+    #pragma omp barrier
 
+    #pragma omp single
+    {
+        mpf_clear(scan_a[2 * num_threads]);
+        mpf_clear(scan_b[2 * num_threads]);
+        free(scan_a);
+        free(scan_b);
+    }
+}
 
 /*
- * This method is used by ParallelChudnovskyAlgorithm procs
- * for computing the first value of dep_a
+ * Computes the Chudnovsky iterations from first to end (not included) and adds them to sum,
+ * starting with the dependencies dep_a, dep_b and dep_c of the first iteration.
+ * Its state is saved in the checkpoint slot (if it is not -1).
  */
-void init_dep_a(mpf_t dep_a, int block_start){
-    mpz_t factorial_n, dividend, divisor;
-    mpf_t float_dividend, float_divisor;
-    mpz_inits(factorial_n, dividend, divisor, NULL);
-    mpf_inits(float_dividend, float_divisor, NULL);
+void Chudnovsky_iterations_MPI(mpf_t sum, int slot, int first, int end, 
+                                    mpf_t dep_a, mpf_t dep_b, mpf_t dep_c, mpf_t c){
+    int i, factor_a;
+    mpf_t dep_a_dividend, dep_a_divisor, aux;
+
+    mpf_inits(dep_a_dividend, dep_a_divisor, aux, NULL);
+    factor_a = 12 * first;
+    mpf_ptr state[] = {sum};
+
+    for(i = first; i < end; i++){
+        checkpoint_poll(slot, i, state);
+        Chudnovsky_iteration(sum, i, dep_a, dep_b, dep_c, aux);
+        //Update dep_a:
+        mpf_set_ui(dep_a_dividend, factor_a + 10);
+        mpf_mul_ui(dep_a_dividend, dep_a_dividend, factor_a + 6);
+        mpf_mul_ui(dep_a_dividend, dep_a_dividend, factor_a + 2);
+        mpf_mul(dep_a_dividend, dep_a_dividend, dep_a);
+
+        mpf_set_ui(dep_a_divisor, i + 1);
+        mpf_pow_ui(dep_a_divisor, dep_a_divisor ,3);
+        mpf_div(dep_a, dep_a_dividend, dep_a_divisor);
+        factor_a += 12;
+
+        //Update dep_b:
+        mpf_mul(dep_b, dep_b, c);
+
+        //Update dep_c:
+        mpf_add_ui(dep_c, dep_c, B);
+    }
+    checkpoint_done(slot, state);
 
-    mpz_fac_ui(factorial_n, block_start);
-    mpz_fac_ui(divisor, 3 * block_start);
-    mpz_fac_ui(dividend, 6 * block_start);
+    //Clear memory
+    mpf_clears(dep_a_dividend, dep_a_divisor, aux, NULL);
+}
 
-    mpz_pow_ui(factorial_n, factorial_n, 3);
-    mpz_mul(divisor, divisor, factorial_n);
+/*
+ * Computes the Chudnovsky iterations from next to end (not included) and adds them to sum.
+ * It is used to restart the progressions of a checkpoint, so the dependencies 
+ * of the next iteration are computed directly. The iterations are consecutive (stride 1),
+ * because each iteration depends on the previous one.
+ */
+void Chudnovsky_progression_MPI(mpf_t sum, int slot, int next, int stride, int end){
+    mpf_t dep_a, dep_b, dep_c, c;
 
-    mpf_set_z(float_dividend, dividend);
-    mpf_set_z(float_divisor, divisor);
+    if (stride != 1){
+        printf("  Chudnovsky progression with stride %d (it must be 1), the checkpoint is corrupted \n\n", stride);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    mpf_init_set_ui(c, C);
+    mpf_neg(c, c);
+    mpf_pow_ui(c, c, 3);
+    mpf_inits(dep_a, dep_b, NULL);
+    get_dep_a_ratio(dep_a, 0, next);            // dep_a(next) = dep_a(next) / dep_a(0)
+    mpf_pow_ui(dep_b, c, next);
+    mpf_init_set_ui(dep_c, B);
+    mpf_mul_ui(dep_c, dep_c, next);
+    mpf_add_ui(dep_c, dep_c, A);
 
-    mpf_div(dep_a, float_dividend, float_divisor);
+    Chudnovsky_iterations_MPI(sum, slot, next, end, dep_a, dep_b, dep_c, c);
 
-    mpz_clears(factorial_n, dividend, divisor, NULL);
-    mpf_clears(float_dividend, float_divisor, NULL);
+    //Clear memory
+    mpf_clears(dep_a, dep_b, dep_c, c, NULL);
 }
 
 /*
@@ -138,100 +245,99 @@ void init_dep_a(mpf_t dep_a, int block_start){
  * The number of iterations is divided by blocks 
  * so each process calculates a part of pi with multiple threads (or just one thread). 
  * Each process will also divide the iterations in blocks
- * among the threads to calculate its part.  
- * Finally, a collective reduction operation will be performed 
- * using a user defined function in OperationsMPI. 
+ * among its threads (any number, not the same in every process) to calculate its part.  
+ * Finally, a reduction of the partial sums will be performed
+ * using reduce_sum in OperationsMPI (reduce_sum_shm with --shm; with 
+ * --overlap, the partial sum of each thread is reduced as soon as it 
+ * finishes, see OverlapMPI). 
+ * With --checkpoint, every process saves the progressions of its threads,
+ * so a failed run can be restarted with --resume (see CheckpointMPI).
  */
 void Chudnovsky_algorithm_MPI(int num_procs, int proc_id, mpf_t pi, 
                                     int num_iterations, int num_threads){
-    int packet_size, position; 
+    int first_worker, total_threads;
+    double start;
     mpf_t local_proc_pi, e, c;  
 
+    //Each process can use a different number of threads
+    MPI_Exscan(&num_threads, &first_worker, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (proc_id == 0) first_worker = 0;
+    MPI_Allreduce(&num_threads, &total_threads, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
     mpf_init_set_ui(local_proc_pi, 0);   
     mpf_init_set_ui(e, E);
     mpf_init_set_ui(c, C);
     mpf_neg(c, c);
     mpf_pow_ui(c, c, 3);
 
-    //Set the number of threads 
-    omp_set_num_threads(num_threads);
-
-    #pragma omp parallel 
-    {
-        int thread_id, i, thread_block_size, thread_block_start, thread_block_end, factor_a;
-        int *distribution;
-        mpf_t local_thread_pi, dep_a, dep_a_dividend, dep_a_divisor, dep_b, dep_c, aux;
-
-        thread_id = omp_get_thread_num();
-        distribution = get_distribution(num_procs, proc_id, num_threads, thread_id, num_iterations);
-        thread_block_size = distribution[0];
-        thread_block_start = distribution[1];
-        thread_block_end = distribution[2];
-
-        mpf_init_set_ui(local_thread_pi, 0);    // private thread pi
-        mpf_inits(dep_a, dep_b, dep_a_dividend, dep_a_divisor, aux, NULL);
-        init_dep_a(dep_a, thread_block_start);
-        mpf_pow_ui(dep_b, c, thread_block_start);
-        mpf_init_set_ui(dep_c, B);
-        mpf_mul_ui(dep_c, dep_c, thread_block_start);
-        mpf_add_ui(dep_c, dep_c, A);
-        factor_a = 12 * thread_block_start;
-
-        //First Phase -> Working on a local variable        
-        #pragma omp parallel for 
-            for(i = thread_block_start; i < thread_block_end; i++){
-                Chudnovsky_iteration(local_thread_pi, i, dep_a, dep_b, dep_c, aux);
-                //Update dep_a:
-                mpf_set_ui(dep_a_dividend, factor_a + 10);
-                mpf_mul_ui(dep_a_dividend, dep_a_dividend, factor_a + 6);
-                mpf_mul_ui(dep_a_dividend, dep_a_dividend, factor_a + 2);
-                mpf_mul(dep_a_dividend, dep_a_dividend, dep_a);
-
-                mpf_set_ui(dep_a_divisor, i + 1);
-                mpf_pow_ui(dep_a_divisor, dep_a_divisor ,3);
-                mpf_div(dep_a, dep_a_dividend, dep_a_divisor);
-                factor_a += 12;
-
-                //Update dep_b:
-                mpf_mul(dep_b, dep_b, c);
-
-                //Update dep_c:
-                mpf_add_ui(dep_c, dep_c, B);
+    if (restart_MPI(num_procs, proc_id, local_proc_pi, CHECKPOINT_CHUDNOVSKY, num_iterations, 
+                        num_threads, Chudnovsky_progression_MPI) != 0){
+        init_checkpoint_MPI(num_procs, proc_id, CHECKPOINT_CHUDNOVSKY, num_iterations, num_threads);
+        init_overlap_MPI(num_threads);
+
+        //Set the number of threads 
+        omp_set_num_threads(num_threads);
+
+        #pragma omp parallel 
+        {
+            int thread_id, slot, thread_block_start, thread_block_end;
+            int *distribution;
+            double start, busy, wait;
+            mpf_t local_thread_pi, dep_a, dep_b, dep_c;
+
+            thread_id = omp_get_thread_num();
+            distribution = get_distribution(total_threads, first_worker + thread_id, num_iterations);
+            thread_block_start = distribution[1];
+            thread_block_end = distribution[2];
+            free(distribution);
+
+            start = phase_clock();
+            mpf_init_set_ui(local_thread_pi, 0);    // private thread pi
+            mpf_inits(dep_a, dep_b, NULL);
+            init_block_seeds_MPI(dep_a, dep_b, c, thread_block_start, thread_block_end);
+            mpf_init_set_ui(dep_c, B);
+            mpf_mul_ui(dep_c, dep_c, thread_block_start);
+            mpf_add_ui(dep_c, dep_c, A);
+            busy = phase_add(PHASE_INIT, start);
+
+            //First Phase -> Working on a local variable        
+            start = phase_clock();
+            slot = open_checkpoint_slot(thread_block_start, 1, thread_block_start, thread_block_end, NULL);
+            Chudnovsky_iterations_MPI(local_thread_pi, slot, thread_block_start, thread_block_end, 
+                                        dep_a, dep_b, dep_c, c);
+            busy += phase_add(PHASE_SERIES, start);
+
+            //Second Phase -> Accumulate the result in the global variable
+            //(or start its reduction among the processes in overlap mode)
+            start = phase_clock();
+            if (reduce_thread_pi_MPI(thread_id, local_thread_pi) != 0){
+                #pragma omp critical
+                mpf_add(local_proc_pi, local_proc_pi, local_thread_pi);
             }
+            wait = phase_add(PHASE_THREAD_REDUCTION, start);
+            record_thread_work(thread_id, thread_block_start, thread_block_end, 1, busy, wait);
 
-        //Second Phase -> Accumulate the result in the global variable 
-        #pragma omp critical
-        mpf_add(local_proc_pi, local_proc_pi, local_thread_pi);
-
-        //Clear thread memory
-        mpf_clears(local_thread_pi, dep_a, dep_a_dividend, dep_a_divisor, dep_b, dep_c, aux, NULL);   
+            //Clear thread memory
+            mpf_clears(local_thread_pi, dep_a, dep_b, dep_c, NULL);   
+        }
     }
+    finish_checkpoint();
     
-    //Create user defined operation
-    MPI_Op add_op;
-    MPI_Op_create((MPI_User_function *)add, 0, &add_op);
-
-    //Set buffers for cumunications and position for pack and unpack information 
-    packet_size = 8 + sizeof(mp_exp_t) + ((local_proc_pi -> _mp_prec + 1) * sizeof(mp_limb_t));
-    char recbuffer[packet_size];
-    char sendbuffer[packet_size];
-
-    //Pack local_proc_pi in sendbuffuer
-    position = pack(sendbuffer, local_proc_pi);
-
-    //Reduce local_proc_pi
-    MPI_Reduce(sendbuffer, recbuffer, position, MPI_PACKED, add_op, 0, MPI_COMM_WORLD);
-
-    //Unpack recbuffer in global Pi and do the last operations to get Pi
+    //Reduce local_proc_pi in global Pi and do the last operations to get Pi
+    start = phase_clock();
+    if (run_options.shm) reduce_sum_shm(pi, local_proc_pi, MPI_COMM_WORLD);
+    else reduce_sum(pi, local_proc_pi, MPI_COMM_WORLD);
+    finish_overlap_MPI(pi, proc_id);
+    phase_add(PHASE_MPI_REDUCTION, start);
     if (proc_id == 0){
-        unpack(recbuffer, pi);
+        start = phase_clock();
         mpf_sqrt(e, e);
         mpf_mul_ui(e, e, D);
         mpf_div(pi, e, pi); 
+        phase_add(PHASE_FINAL, start);
     }    
 
     //Clear process memory
-    MPI_Op_free(&add_op);
     mpf_clears(local_proc_pi, e, c, NULL);
 }
 
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gmp.h>
+#include "mpi.h"
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/Common/Timers.h"
+
+#define CALIBRATION_ITERATIONS 8    // Iterations per thread measured to get the throughput
+#define DYNAMIC_FRACTION 0.1        // Fraction of the iterations given on demand in the dynamic distribution
+#define CHUNKS_PER_PROC 4           // Chunks of the dynamic fraction per process
+
+
+/*
+ * Reads the throughput (iterations per second) of this node from the calibration file. 
+ * Each line of the file has the processor name and its throughput:
+ *   processor_name iterations_per_second
+ * It returns 0 if the file or the processor are not found.
+ */
+double read_throughput(char * file_name, int proc_id){
+    FILE * file;
+    char processor_name[MPI_MAX_PROCESSOR_NAME], name[256];
+    int name_length;
+    double throughput, value;
+
+    file = fopen(file_name, "r");
+    if(file == NULL){
+        if (proc_id == 0) printf("  Calibration file %s not found, the throughput is measured \n", file_name);
+        return 0;
+    }
+
+    MPI_Get_processor_name(processor_name, &name_length);
+    throughput = 0;
+    while(fscanf(file, "%255s %lf", name, &value) == 2){
+        if (strcmp(name, processor_name) == 0){
+            throughput = value;
+            break;
+        }
+    }
+
+    fclose(file);
+    return throughput;
+}
+
+/*
+ * Returns the throughput of this process (iterations per second) for the algorithm 
+ * computed by compute_block. It is read from the calibration file if the node is listed there, 
+ * otherwise it is measured computing CALIBRATION_ITERATIONS iterations with every thread.
+ */
+double get_throughput(int proc_id, int num_iterations, int num_threads, void (*compute_block)(mpf_t, int, int, int)){
+    int calibration_iterations;
+    double throughput, start_time, elapsed_time, phases[NUM_PHASES];
+    mpf_t calibration_pi;
+
+    throughput = 0;
+    if (run_options.calibration_file != NULL) throughput = read_throughput(run_options.calibration_file, proc_id);
+    if (throughput > 0) return throughput;
+
+    calibration_iterations = CALIBRATION_ITERATIONS * num_threads;
+    if (calibration_iterations > num_iterations) calibration_iterations = num_iterations;
+
+    save_phases(phases);
+    mpf_init_set_ui(calibration_pi, 0);
+    start_time = MPI_Wtime();
+    compute_block(calibration_pi, 0, calibration_iterations, num_threads);
+    elapsed_time = MPI_Wtime() - start_time;
+    mpf_clear(calibration_pi);
+    reset_thread_work();                    // The calibration is not part of the load of the threads
+    restore_phases(phases);                 // nor of the time of the phases
+
+    return (elapsed_time > 0) ? calibration_iterations / elapsed_time : 1;
+}
+
+/*
+ * This method provides the block of iterations of each process
+ * depending on the distribution option:
+ *   equal    -> blocks of the same size
+ *   weighted -> blocks proportional to the throughput of each process
+ *   dynamic  -> weighted blocks of the first (1 - DYNAMIC_FRACTION) iterations,
+ *               the rest are given on demand with compute_dynamic_blocks
+ * It stores three integers in block:
+ *   block[0] -> block start
+ *   block[1] -> block end 
+ *   block[2] -> first iteration given on demand (num_iterations if there are not)
+ */
+void get_process_block(int num_procs, int proc_id, int num_iterations, int num_threads, 
+                        void (*compute_block)(mpf_t, int, int, int), int * block){
+    int i, block_size, distributed_iterations;
+    double throughput, total_throughput, previous_throughput, * throughputs;
+
+    if (run_options.distribution == EQUAL_DISTRIBUTION){
+        block_size = (num_iterations + num_procs - 1) / num_procs;
+        block[0] = proc_id * block_size;
+        block[1] = block[0] + block_size;
+        if (block[0] > num_iterations) block[0] = num_iterations;
+        if (block[1] > num_iterations) block[1] = num_iterations;
+        block[2] = num_iterations;
+        return;
+    }
+
+    //Share the throughput of every process
+    throughputs = malloc(sizeof(double) * num_procs);
+    throughput = get_throughput(proc_id, num_iterations, num_threads, compute_block);
+    MPI_Allgather(&throughput, 1, MPI_DOUBLE, throughputs, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+
+    total_throughput = 0;
+    previous_throughput = 0;
+    for(i = 0; i < num_procs; i++){
+        if (i < proc_id) previous_throughput += throughputs[i];
+        total_throughput += throughputs[i];
+    }
+
+    distributed_iterations = num_iterations;
+    if (run_options.distribution == DYNAMIC_DISTRIBUTION) distributed_iterations -= num_iterations * DYNAMIC_FRACTION;
+
+    block[0] = distributed_iterations * (previous_throughput / total_throughput);
+    block[1] = distributed_iterations * ((previous_throughput + throughput) / total_throughput);
+    if (proc_id == num_procs - 1) block[1] = distributed_iterations;
+    block[2] = distributed_iterations;
+
+    free(throughputs);
+}
+
+/*
+ * Second pass of the dynamic distribution. The iterations from pool_start to num_iterations
+ * are divided in chunks that the processes take when they finish their blocks,
+ * using an atomic counter in a window of the process 0.
+ * IMPORTANT: It must be called by every process
+ */
+void compute_dynamic_blocks(mpf_t local_proc_pi, int pool_start, int num_iterations, 
+                        int num_procs, int num_threads, void (*compute_block)(mpf_t, int, int, int)){
+    long * counter, chunk_size, chunk_start;
+    int proc_id, chunk_end;
+    MPI_Win window;
+
+    if (pool_start >= num_iterations) return;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &proc_id);
+    MPI_Win_allocate((proc_id == 0) ? sizeof(long) : 0, sizeof(long), MPI_INFO_NULL, 
+                        MPI_COMM_WORLD, &counter, &window);
+    if (proc_id == 0){
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, window);
+        *counter = pool_start;
+        MPI_Win_unlock(0, window);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    //Rounded up, so there are at most num_procs * CHUNKS_PER_PROC chunks (see get_max_blocks)
+    chunk_size = (num_iterations - pool_start + num_procs * CHUNKS_PER_PROC - 1) / (num_procs * CHUNKS_PER_PROC);
+    if (chunk_size < num_threads) chunk_size = num_threads;
+
+    while(1){
+        MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, window);
+        MPI_Fetch_and_op(&chunk_size, &chunk_start, MPI_LONG, 0, 0, MPI_SUM, window);
+        MPI_Win_unlock(0, window);
+        if (chunk_start >= num_iterations) break;
+
+        chunk_end = (chunk_start + chunk_size < num_iterations) ? chunk_start + chunk_size : num_iterations;
+        compute_block(local_proc_pi, chunk_start, chunk_end, num_threads);
+    }
+
+    MPI_Win_free(&window);
+}
+
+/*
+ * Maximum number of blocks that a process can compute: its own block
+ * and every chunk of the dynamic distribution
+ */
+int get_max_blocks(int num_procs){
+    return 1 + num_procs * CHUNKS_PER_PROC;
+}
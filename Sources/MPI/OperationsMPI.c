@@ -1,35 +1,57 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <gmp.h>
 #include "mpi.h"
+#include "../../Headers/Common/Timers.h"
+#include "../../Headers/Common/Trace.h"
+
+#define SEGMENT_LIMBS 4096
 
 /*
  * Pack mpf_t type
+ * Only the significant limbs (abs(_mp_size)) are packed after the header (size, exponent),
+ * but the buffer should have space for a full packet:
+ *   packet_size = 8 + sizeof(mp_exp_t) + ((data -> _mp_prec + 1) * sizeof(mp_limb_t))
  * IMPORTANT: mpf_t data should have been previously initialized
  */
 int pack(void * buffer, mpf_t data){
-    int position, packet_size;
+    int position, packet_size, size;
+    double start;
+    start = (trace_enabled) ? phase_clock() : 0;
     packet_size = 8 + sizeof(mp_exp_t) + ((data -> _mp_prec + 1) * sizeof(mp_limb_t));
+    size = (data -> _mp_size >= 0) ? data -> _mp_size : -(data -> _mp_size);
     position = 0;
     MPI_Pack(&data -> _mp_size, 1, MPI_INT, buffer, packet_size, &position, MPI_COMM_WORLD);
     MPI_Pack(&data -> _mp_prec, 1, MPI_INT, buffer, packet_size, &position, MPI_COMM_WORLD);
     MPI_Pack(&data -> _mp_exp, sizeof(mp_exp_t), MPI_BYTE, buffer, packet_size, &position, MPI_COMM_WORLD);
-    MPI_Pack( data -> _mp_d,  (data -> _mp_prec + 1) * sizeof(mp_limb_t), MPI_BYTE, buffer, packet_size, &position, MPI_COMM_WORLD);
+    MPI_Pack( data -> _mp_d,  size * sizeof(mp_limb_t), MPI_BYTE, buffer, packet_size, &position, MPI_COMM_WORLD);
+    if (trace_enabled) trace_event("MPI pack", start);
     return position;
 }
 
 /*
  * Unpack mpf_t type
+ * The precision of data is kept. If the packed value has more limbs than data 
+ * can store, only the most significant ones are unpacked.
  * IMPORTANT: mpf_t data should have been previously initialized
  */
 void unpack(void * buffer, mpf_t data){
-    int position, packet_size;
+    int position, packet_size, size, prec, skipped;
+    double start;
+    start = (trace_enabled) ? phase_clock() : 0;
     packet_size = 8 + sizeof(mp_exp_t) + ((data -> _mp_prec + 1) * sizeof(mp_limb_t));
     position = 0;
     MPI_Unpack(buffer, packet_size, &position, &data -> _mp_size, 1, MPI_INT, MPI_COMM_WORLD);
-    MPI_Unpack(buffer, packet_size, &position, &data -> _mp_prec, 1, MPI_INT, MPI_COMM_WORLD);
+    MPI_Unpack(buffer, packet_size, &position, &prec, 1, MPI_INT, MPI_COMM_WORLD);
     MPI_Unpack(buffer, packet_size, &position, &data -> _mp_exp, sizeof(mp_exp_t), MPI_BYTE, MPI_COMM_WORLD);
-    MPI_Unpack(buffer, packet_size, &position,  data -> _mp_d, (data -> _mp_prec + 1) * sizeof(mp_limb_t) , MPI_BYTE, MPI_COMM_WORLD);
+    size = (data -> _mp_size >= 0) ? data -> _mp_size : -(data -> _mp_size);
+    skipped = (size > data -> _mp_prec + 1) ? size - (data -> _mp_prec + 1) : 0;
+    position += skipped * sizeof(mp_limb_t);
+    MPI_Unpack(buffer, packet_size + skipped * sizeof(mp_limb_t), &position, data -> _mp_d, 
+                (size - skipped) * sizeof(mp_limb_t), MPI_BYTE, MPI_COMM_WORLD);
+    if (skipped > 0) data -> _mp_size = (data -> _mp_size >= 0) ? size - skipped : skipped - size;
+    if (trace_enabled) trace_event("MPI unpack", start);
 }
 
 /*
@@ -61,4 +83,264 @@ void mul(void * invec, void * inoutvec, int *len, MPI_Datatype *dtype){
 }
 
 
+/*
+ * Stores the mpf_t data as a fixed point integer of num_limbs limbs in two's complement.
+ * The most significant limb of the window has the exponent top (in limbs), 
+ * so every process that uses the same window can add the limbs directly.
+ * Limbs of data below the window are truncated.
+ */
+void mpf_to_fixed(mp_limb_t * limbs, int num_limbs, long top, mpf_t data){
+    int i, size, index;
+    long bottom;
+    double start;
+
+    start = (trace_enabled) ? phase_clock() : 0;
+    for(i = 0; i < num_limbs; i++) limbs[i] = 0;
+    size = (data -> _mp_size >= 0) ? data -> _mp_size : -(data -> _mp_size);
+    bottom = top - num_limbs;
+
+    for(i = 0; i < size; i++){
+        index = (data -> _mp_exp - size + i) - bottom;
+        if (index >= 0) limbs[index] = data -> _mp_d[i];
+    }
+    if (data -> _mp_size < 0) mpn_neg(limbs, limbs, num_limbs);
+    if (trace_enabled) trace_event("fixed convert", start);
+}
+
+/*
+ * Sets the mpf_t data from a fixed point integer in two's complement 
+ * whose most significant limb has the exponent top (in limbs)
+ * IMPORTANT: The limbs are overwritten
+ */
+void fixed_to_mpf(mpf_t data, mp_limb_t * limbs, int num_limbs, long top){
+    int negative;
+    long bottom;
+    double start;
+    mpz_t integer;
+
+    start = (trace_enabled) ? phase_clock() : 0;
+    negative = (limbs[num_limbs - 1] >> (GMP_NUMB_BITS - 1)) != 0;
+    if (negative) mpn_neg(limbs, limbs, num_limbs);
+
+    mpz_init(integer);
+    mpz_import(integer, num_limbs, -1, sizeof(mp_limb_t), 0, 0, limbs);
+    mpf_set_z(data, integer);
+    mpz_clear(integer);
+
+    bottom = top - num_limbs;
+    if (bottom < 0) mpf_div_2exp(data, data, (unsigned long) -bottom * GMP_NUMB_BITS);
+    else mpf_mul_2exp(data, data, (unsigned long) bottom * GMP_NUMB_BITS);
+    if (negative) mpf_neg(data, data);
+    if (trace_enabled) trace_event("fixed restore", start);
+}
+
+/*
+ * Significant window of a fixed point integer in two's complement: the limbs
+ * below window[0] are zero and the limbs from window[1] are the sign extension
+ * of the limb window[1] - 1. An empty window (zero) is [num_limbs, 0).
+ */
+void get_fixed_window(long * window, mp_limb_t * limbs, int num_limbs){
+    int low, high;
+    mp_limb_t fill;
+
+    low = 0;
+    while (low < num_limbs && limbs[low] == 0) low++;
+    if (low == num_limbs){
+        window[0] = num_limbs;
+        window[1] = 0;
+        return;
+    }
+
+    fill = (limbs[num_limbs - 1] >> (GMP_NUMB_BITS - 1)) ? GMP_NUMB_MAX : 0;
+    high = num_limbs;
+    while (high > low && limbs[high - 1] == fill) high--;
+    if (high == low || (limbs[high - 1] ^ fill) >> (GMP_NUMB_BITS - 1)) high++;
+    window[0] = low;
+    window[1] = high;
+}
+
+/*
+ * Sum reduction of mpf_t values in the process 0 of the communicator
+ * All the values are moved to the same fixed point window, so they are added 
+ * limb by limb without unpacking them in mpf_t values.
+ * Before the limbs, each process sends to its parent a header with the window 
+ * of significant limbs of its subtree, so the zeros below the value and the 
+ * sign extension above it (the leading limbs of the processes working with 
+ * the smallest terms) are never sent. The sign travels in the most significant 
+ * bit of the window.
+ * The limbs are sent in segments of SEGMENT_LIMBS limbs (from the least significant)
+ * over a binomial tree with non-blocking communications, so a process can add 
+ * and forward a segment while the next ones are still arriving. 
+ * The carry of each segment is propagated to the following ones.
+ * IMPORTANT: local should have the same precision in every process
+ */
+void reduce_sum(mpf_t result, mpf_t local, MPI_Comm comm){
+    int num_procs, proc_id, num_limbs, num_segments, num_children, parent, mask, c, s;
+    int first, last, child_first, child_last;
+    int * children;
+    long exp, top, window[2], * children_windows;
+    mp_limb_t carry, * limbs, ** children_limbs;
+    MPI_Request * recv_requests, * send_requests;
+
+    MPI_Comm_size(comm, &num_procs);
+    MPI_Comm_rank(comm, &proc_id);
+
+    //Agree on the fixed point window: one extra limb avoids overflows in the sum
+    exp = (local -> _mp_size == 0) ? LONG_MIN : local -> _mp_exp;
+    MPI_Allreduce(&exp, &top, 1, MPI_LONG, MPI_MAX, comm);
+    if (top == LONG_MIN){
+        if (proc_id == 0) mpf_set_ui(result, 0);
+        return;
+    }
+    top += 1;
+    num_limbs = local -> _mp_prec + 2;
+    num_segments = (num_limbs + SEGMENT_LIMBS - 1) / SEGMENT_LIMBS;
+
+    //Children and parent in the binomial tree
+    children = malloc(sizeof(int) * num_procs);
+    num_children = 0;
+    parent = -1;
+    for(mask = 1; mask < num_procs; mask <<= 1){
+        if (proc_id & mask){
+            parent = proc_id - mask;
+            break;
+        }
+        if (proc_id + mask < num_procs) children[num_children++] = proc_id + mask;
+    }
+
+    //Heap buffers allocated once
+    limbs = malloc(sizeof(mp_limb_t) * num_limbs);
+    children_limbs = malloc(sizeof(mp_limb_t *) * (num_children + 1));
+    children_windows = malloc(sizeof(long) * 2 * (num_children + 1));
+    recv_requests = malloc(sizeof(MPI_Request) * (num_children * num_segments + 1));
+    send_requests = malloc(sizeof(MPI_Request) * num_segments);
+    mpf_to_fixed(limbs, num_limbs, top, local);
+
+    //Headers: the window of the subtree covers the windows of the children plus a limb for the carries
+    get_fixed_window(window, limbs, num_limbs);
+    carry = 0;
+    for(c = 0; c < num_children; c++){
+        MPI_Recv(&children_windows[2 * c], 2, MPI_LONG, children[c], 0, comm, MPI_STATUS_IGNORE);
+        if (children_windows[2 * c] >= children_windows[2 * c + 1]) continue;
+        if (children_windows[2 * c] < window[0]) window[0] = children_windows[2 * c];
+        if (children_windows[2 * c + 1] > window[1]) window[1] = children_windows[2 * c + 1];
+        carry = 1;
+    }
+    window[1] += carry;
+    if (window[1] > num_limbs) window[1] = num_limbs;
+    if (parent >= 0) MPI_Send(window, 2, MPI_LONG, parent, 0, comm);
+
+    //Post the receives of the significant segments of every child
+    for(c = 0; c < num_children; c++){
+        children_limbs[c] = malloc(sizeof(mp_limb_t) * num_limbs);
+        for(s = 0; s < num_segments; s++){
+            child_first = (s * SEGMENT_LIMBS > children_windows[2 * c]) ? s * SEGMENT_LIMBS : children_windows[2 * c];
+            child_last = ((s + 1) * SEGMENT_LIMBS < children_windows[2 * c + 1]) ? (s + 1) * SEGMENT_LIMBS : children_windows[2 * c + 1];
+            recv_requests[c * num_segments + s] = MPI_REQUEST_NULL;
+            if (child_first >= child_last) continue;
+            MPI_Irecv(children_limbs[c] + child_first, (child_last - child_first) * sizeof(mp_limb_t), MPI_BYTE, 
+                        children[c], 0, comm, &recv_requests[c * num_segments + s]);
+        }
+    }
+
+    //Add the segments from the least significant and forward them to the parent
+    for(s = 0; s < num_segments; s++){
+        send_requests[s] = MPI_REQUEST_NULL;
+        for(c = 0; c < num_children; c++){
+            if (recv_requests[c * num_segments + s] == MPI_REQUEST_NULL) continue;
+            child_first = (s * SEGMENT_LIMBS > children_windows[2 * c]) ? s * SEGMENT_LIMBS : children_windows[2 * c];
+            child_last = ((s + 1) * SEGMENT_LIMBS < children_windows[2 * c + 1]) ? (s + 1) * SEGMENT_LIMBS : children_windows[2 * c + 1];
+            MPI_Wait(&recv_requests[c * num_segments + s], MPI_STATUS_IGNORE);
+            carry = mpn_add_n(limbs + child_first, limbs + child_first, children_limbs[c] + child_first, child_last - child_first);
+            if (carry && child_last < num_limbs){
+                mpn_add_1(limbs + child_last, limbs + child_last, num_limbs - child_last, carry);
+            }
+            //A negative child is extended with ones above its window: -2^(limb bits * window end)
+            if (child_last == children_windows[2 * c + 1] && child_last < num_limbs &&
+                        (children_limbs[c][child_last - 1] >> (GMP_NUMB_BITS - 1))){
+                mpn_sub_1(limbs + child_last, limbs + child_last, num_limbs - child_last, 1);
+            }
+        }
+        first = (s * SEGMENT_LIMBS > window[0]) ? s * SEGMENT_LIMBS : window[0];
+        last = ((s + 1) * SEGMENT_LIMBS < window[1]) ? (s + 1) * SEGMENT_LIMBS : window[1];
+        if (parent >= 0 && first < last){
+            MPI_Isend(limbs + first, (last - first) * sizeof(mp_limb_t), MPI_BYTE, 
+                        parent, 0, comm, &send_requests[s]);
+        }
+    }
+    if (parent >= 0) MPI_Waitall(num_segments, send_requests, MPI_STATUSES_IGNORE);
+
+    if (proc_id == 0) fixed_to_mpf(result, limbs, num_limbs, top);
+
+    //Clear memory
+    for(c = 0; c < num_children; c++) free(children_limbs[c]);
+    free(children_limbs);
+    free(children_windows);
+    free(children);
+    free(limbs);
+    free(recv_requests);
+    free(send_requests);
+}
+
+/*
+ * Sum reduction of mpf_t values in the process 0 of the communicator, using shared memory
+ * among the processes of the same node (MPI_Comm_split_type). 
+ * Each process stores its value as fixed point limbs in a shared window (the same window
+ * of limbs in every process of comm), so the leader of the node (its first process) adds 
+ * them by direct access to the limbs of the others. In two's complement the negative 
+ * values need no special treatment.
+ * Then only the sum of each node is reduced among the leaders with reduce_sum.
+ * IMPORTANT: local should have the same precision in every process
+ */
+void reduce_sum_shm(mpf_t result, mpf_t local, MPI_Comm comm){
+    int proc_id, node_id, node_procs, num_limbs, disp_unit, p;
+    long exp, top;
+    mp_limb_t * limbs, * node_limbs;
+    MPI_Aint window_size;
+    MPI_Comm node_comm, leaders_comm;
+    MPI_Win window;
+    mpf_t node_sum;
+
+    MPI_Comm_rank(comm, &proc_id);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, proc_id, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &node_id);
+    MPI_Comm_size(node_comm, &node_procs);
+    MPI_Comm_split(comm, (node_id == 0) ? 0 : MPI_UNDEFINED, proc_id, &leaders_comm);
+
+    //Agree on the fixed point window: one extra limb avoids overflows in the sum
+    exp = (local -> _mp_size == 0) ? LONG_MIN : local -> _mp_exp;
+    MPI_Allreduce(&exp, &top, 1, MPI_LONG, MPI_MAX, comm);
+    if (top == LONG_MIN){
+        if (proc_id == 0) mpf_set_ui(result, 0);
+        MPI_Comm_free(&node_comm);
+        if (node_id == 0) MPI_Comm_free(&leaders_comm);
+        return;
+    }
+    top += 1;
+    num_limbs = local -> _mp_prec + 2;
+
+    //Every process of the node writes its limbs in its part of the shared window
+    window_size = (MPI_Aint) num_limbs * sizeof(mp_limb_t);
+    MPI_Win_allocate_shared(window_size, sizeof(mp_limb_t), MPI_INFO_NULL, node_comm, &limbs, &window);
+    MPI_Win_fence(0, window);
+    mpf_to_fixed(limbs, num_limbs, top, local);
+    MPI_Win_fence(0, window);
 
+    //The leader adds the limbs of the other processes of the node and reduces the node sums
+    if (node_id == 0){
+        for(p = 1; p < node_procs; p++){
+            MPI_Win_shared_query(window, p, &window_size, &disp_unit, &node_limbs);
+            mpn_add_n(limbs, limbs, node_limbs, num_limbs);
+        }
+        mpf_init(node_sum);
+        fixed_to_mpf(node_sum, limbs, num_limbs, top);
+        reduce_sum(result, node_sum, leaders_comm);
+        mpf_clear(node_sum);
+        MPI_Comm_free(&leaders_comm);
+    }
+    MPI_Win_fence(0, window);
+
+    //Clear memory
+    MPI_Win_free(&window);
+    MPI_Comm_free(&node_comm);
+}
@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <gmp.h>
+#include "mpi.h"
+#include "../../Headers/Common/Conversion.h"
+#include "../../Headers/Common/Check_decimals.h"
+#include "../../Headers/Common/Timers.h"
+
+#define OUTPUT_TAG 36
+
+
+/************************************************************************************
+ * Distributed output and check of the decimals (--output file)                     *
+ * Pi is scaled to the integer N = floor(pi * 10^digits) in process 0, with all the *
+ * decimals that can be accurately represented, and its digits are divided in one   *
+ * segment per process, ordered by process:                                         *
+ *      N = SUMMATORY( segment(p) * 10^(segment_digits * (num_procs - 1 - p)) )     *
+ *                                                                                  *
+ * The conversion is done by divide and conquer: the process that holds the         *
+ * segments of a group of processes divides them by a power of ten, keeps the high  *
+ * half and sends the low half to the first process of the second half. After       *
+ * log2(num_procs) steps every process has its own segment, converts it to decimal  *
+ * with its threads (see Conversion), compares it with the correct pi number at its *
+ * position (see Check_decimals) and writes the part of the first num_decimals      *
+ * decimals at its offset with MPI-IO. The decimals that match are the segments     *
+ * that match completely until the first mismatch, which is sent to process 0.      *
+ *                                                                                  *
+ * The file has the same format as Resources/numeroPiCorrecto.txt ("3.1415...").    *
+ *                                                                                  *
+ ************************************************************************************/
+
+double output_time = 0;
+
+
+/*
+ * Sends a non negative integer to the process dest: its number of limbs and the limbs.
+ */
+void send_integer_MPI(mpz_t value, int dest){
+    int size;
+
+    size = mpz_size(value);
+    MPI_Send(&size, 1, MPI_INT, dest, OUTPUT_TAG, MPI_COMM_WORLD);
+    MPI_Send(mpz_limbs_read(value), size * sizeof(mp_limb_t), MPI_BYTE, dest, OUTPUT_TAG, MPI_COMM_WORLD);
+}
+
+void receive_integer_MPI(mpz_t value, int source){
+    int size;
+    mp_limb_t * limbs;
+
+    MPI_Recv(&size, 1, MPI_INT, source, OUTPUT_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    limbs = mpz_limbs_write(value, (size > 0) ? size : 1);
+    MPI_Recv(limbs, size * sizeof(mp_limb_t), MPI_BYTE, source, OUTPUT_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    mpz_limbs_finish(value, size);
+}
+
+/*
+ * Scales pi (only in process 0) to the integer with its first num_decimals decimals
+ * and gets the number of digits of its integer part.
+ */
+void scale_pi_MPI(mpz_t value, int * int_digits, mpf_t pi, int num_decimals){
+    mpz_t int_part, power;
+    mpf_t scaled;
+
+    mpz_inits(int_part, power, NULL);
+    mpf_init2(scaled, mpf_get_prec(pi) + 4 * num_decimals);
+
+    mpz_set_f(int_part, pi);
+    *int_digits = (mpz_sgn(int_part) == 0) ? 1 : mpz_sizeinbase(int_part, 10);
+    mpz_ui_pow_ui(power, 10, *int_digits - 1);
+    if (*int_digits > 1 && mpz_cmp(power, int_part) > 0) (*int_digits)--;     // mpz_sizeinbase can be one more
+
+    mpz_ui_pow_ui(power, 10, num_decimals);
+    mpf_set_z(scaled, power);
+    mpf_mul(scaled, scaled, pi);
+    mpz_set_f(value, scaled);
+
+    //Clear memory
+    mpz_clears(int_part, power, NULL);
+    mpf_clear(scaled);
+}
+
+/*
+ * Converts the segment of the process to decimal, with the leading zeros
+ * and the decimal point (first process).
+ * It returns the number of characters stored in buffer.
+ */
+int segment_to_string_MPI(char * buffer, mpz_t segment, int segment_digits, int int_digits,
+                                int proc_id, int num_threads){
+    int length;
+    double start;
+
+    start = phase_clock();
+    mpz_to_digits(buffer, segment, segment_digits, num_threads);
+    length = segment_digits;
+    if (proc_id == 0){
+        memmove(buffer + int_digits + 1, buffer + int_digits, length - int_digits);
+        buffer[int_digits] = '.';
+        length++;
+    }
+    phase_add(PHASE_CONVERSION, start);
+
+    return length;
+}
+
+/*
+ * Compares the characters of the segment of every process with the correct pi number
+ * from its position. It returns the number of decimals that match (in process 0),
+ * and the first mismatch is sent to process 0 to be shown by print_mismatch.
+ * IMPORTANT: It must be called by every process
+ */
+int check_segments_MPI(char * buffer, int length, long position, int proc_id, int num_procs){
+    int proc, mismatch_proc;
+    long matched, total, * all_matched, windows[2];
+    int * lengths;
+
+    matched = compare_correct_pi(buffer, length, position);
+    all_matched = malloc(sizeof(long) * num_procs);
+    lengths = malloc(sizeof(int) * num_procs);
+    MPI_Gather(&matched, 1, MPI_LONG, all_matched, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+    MPI_Gather(&length, 1, MPI_INT, lengths, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    //The decimals match until the first segment that does not match completely
+    total = 0;
+    mismatch_proc = -1;
+    if (proc_id == 0){
+        for(proc = 0; proc < num_procs && mismatch_proc < 0; proc++){
+            total += all_matched[proc];
+            if (all_matched[proc] < lengths[proc]) mismatch_proc = proc;
+        }
+    }
+    MPI_Bcast(&mismatch_proc, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (mismatch_proc > 0 && proc_id == mismatch_proc){
+        windows[0] = check_mismatch;
+        windows[1] = check_window_start;
+        MPI_Send(windows, 2, MPI_LONG, 0, OUTPUT_TAG, MPI_COMM_WORLD);
+        MPI_Send(check_computed_window, sizeof(check_computed_window), MPI_CHAR, 0, OUTPUT_TAG, MPI_COMM_WORLD);
+        MPI_Send(check_correct_window, sizeof(check_correct_window), MPI_CHAR, 0, OUTPUT_TAG, MPI_COMM_WORLD);
+    } else if (mismatch_proc > 0 && proc_id == 0){
+        MPI_Recv(windows, 2, MPI_LONG, mismatch_proc, OUTPUT_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Recv(check_computed_window, sizeof(check_computed_window), MPI_CHAR, mismatch_proc, OUTPUT_TAG,
+                    MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Recv(check_correct_window, sizeof(check_correct_window), MPI_CHAR, mismatch_proc, OUTPUT_TAG,
+                    MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        check_mismatch = windows[0];
+        check_window_start = windows[1];
+    }
+
+    //Clear memory
+    free(all_matched);
+    free(lengths);
+
+    return (total < 2) ? 0 : total - 2;
+}
+
+/*
+ * Writes the first num_decimals decimals of pi (only in process 0) in file_name and checks
+ * all its accurate decimals. Every process converts one segment of the digits with
+ * num_threads threads, checks it and writes it. It returns the number of decimals that
+ * match (in process 0).
+ * IMPORTANT: It must be called by every process
+ */
+int write_decimals_MPI(char * file_name, mpf_t pi, int num_decimals, int proc_id, int num_procs, int num_threads){
+    int digits[3], total_digits, int_digits, accurate_decimals, segment_digits, first_digits, my_digits;
+    int first, num, half, length, write_length, error, decimals;
+    long position, file_length;
+    double start, check_time;
+    char * buffer;
+    MPI_File file;
+    mpz_t value, low, power;
+
+    start = MPI_Wtime();
+    mpz_inits(value, low, power, NULL);
+    if (proc_id == 0){
+        //All the decimals that can be accurately represented are checked
+        accurate_decimals = get_mpf_decimals(pi);
+        if (accurate_decimals < num_decimals) accurate_decimals = num_decimals;
+        scale_pi_MPI(value, &int_digits, pi, accurate_decimals);
+        digits[0] = int_digits + accurate_decimals;
+        digits[1] = int_digits;
+        digits[2] = accurate_decimals;
+    }
+    MPI_Bcast(digits, 3, MPI_INT, 0, MPI_COMM_WORLD);
+    total_digits = digits[0];
+    int_digits = digits[1];
+    accurate_decimals = digits[2];
+
+    //The first segment also has the integer part and the digits left over
+    segment_digits = accurate_decimals / num_procs;
+    first_digits = total_digits - (num_procs - 1) * segment_digits;
+    my_digits = (proc_id == 0) ? first_digits : segment_digits;
+
+    //Divide and conquer: the process first holds the segments of the processes first .. first + num - 1
+    first = 0;
+    num = num_procs;
+    while(num > 1){
+        half = num / 2;
+        if (proc_id == first){
+            mpz_ui_pow_ui(power, 10, (unsigned long) (num - half) * segment_digits);
+            mpz_tdiv_qr(value, low, value, power);
+            send_integer_MPI(low, first + half);
+        } else if (proc_id == first + half){
+            receive_integer_MPI(value, first);
+        }
+        if (proc_id < first + half){
+            num = half;
+        } else {
+            first += half;
+            num -= half;
+        }
+    }
+
+    //Each process converts and checks its own segment
+    buffer = malloc(my_digits + 2);
+    length = segment_to_string_MPI(buffer, value, my_digits, int_digits, proc_id, num_threads);
+    position = (proc_id == 0) ? 0 : first_digits + 1 + (long) (proc_id - 1) * segment_digits;
+    check_time = MPI_Wtime();
+    decimals = check_segments_MPI(buffer, length, position, proc_id, num_procs);
+    check_time = MPI_Wtime() - check_time;
+
+    //Only the characters of the first num_decimals decimals are written, with the end of line
+    file_length = int_digits + 1 + num_decimals;
+    write_length = (position >= file_length) ? 0 : (position + length > file_length) ? file_length - position : length;
+    if (position <= file_length && file_length <= position + length){
+        if (file_length < position + length || proc_id == num_procs - 1) buffer[write_length++] = '\n';
+    }
+
+    error = MPI_File_open(MPI_COMM_WORLD, file_name, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+    if (error == MPI_SUCCESS){
+        MPI_File_set_size(file, 0);
+        MPI_File_write_at_all(file, (MPI_Offset) position, buffer, write_length, MPI_CHAR, MPI_STATUS_IGNORE);
+        MPI_File_close(&file);
+    } else if (proc_id == 0){
+        printf("  Output file %s could not be written \n", file_name);
+    }
+    output_time = MPI_Wtime() - start - check_time;
+
+    //Clear memory
+    free(buffer);
+    mpz_clears(value, low, power, NULL);
+
+    return decimals;
+}
+
+void print_output_MPI(char * file_name, int num_decimals){
+    printf("  Decimals written to %s: %d (%f seconds) \n", file_name, num_decimals, output_time);
+}
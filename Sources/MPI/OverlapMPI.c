@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <gmp.h>
+#include <omp.h>
+#include "mpi.h"
+#include "../../Headers/MPI/OperationsMPI.h"
+#include "../../Headers/Common/Options.h"
+
+
+/************************************************************************************
+ * Overlapped reduction (--overlap)                                                 *
+ * Without it, every process waits for all of its threads before the reduction      *
+ * among the processes starts. In this mode, when a thread finishes its iterations  *
+ * it starts a non-blocking reduction of its own partial sum (MPI_Ireduce) and      *
+ * drives it forward while the rest of threads are still iterating.                 *
+ *                                                                                  *
+ * The partial sum of thread t of every process is reduced in the slot t, which has *
+ * its own communicator, so the threads of the processes can finish in any order.   *
+ * There are as many slots as threads in the biggest process; the processes with    *
+ * less threads reduce a zero in the remaining slots at the end.                    *
+ * It needs MPI_THREAD_MULTIPLE, as every thread does MPI calls.                    *
+ *                                                                                  *
+ * The time hidden of each reduction is from its start to its completion or to the  *
+ * end of the computation of the process, whichever is first: a reduction that only *
+ * progresses in the final MPI_Waitsome hides nothing of the time it takes there.   *
+ *                                                                                  *
+ ************************************************************************************/
+
+int overlap_slots = 0;                      // Number of slots (0 if the mode is not in use)
+int overlap_active;                         // Threads of the process still computing
+int overlap_packet_size;
+int * overlap_started;
+char * overlap_sendbuffer, * overlap_recbuffer;
+MPI_Comm * overlap_comms;
+MPI_Request * overlap_requests;
+MPI_Op overlap_op;
+MPI_Datatype overlap_type;                  // A whole packet, so the reduction is never split
+double * overlap_starts, * overlap_ends;    // Start and completion of the reduction of each slot
+double overlap_compute_end;                 // When the last thread of the process finished
+double overlap_time = 0, overlap_reduction_time = 0;     // Mean of the processes, for the report
+
+
+/*
+ * Opens one reduction slot per thread of the biggest process.
+ * It does nothing if the overlap mode is not enabled.
+ * IMPORTANT: It must be called by every process, before its parallel region
+ */
+void init_overlap_MPI(int num_threads){
+    int i;
+    mpf_t aux;
+
+    if (!run_options.overlap) return;
+
+    MPI_Allreduce(&num_threads, &overlap_slots, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+    mpf_init(aux);
+    overlap_packet_size = 8 + sizeof(mp_exp_t) + ((aux -> _mp_prec + 1) * sizeof(mp_limb_t));
+    mpf_clear(aux);
+
+    overlap_sendbuffer = malloc(overlap_packet_size * overlap_slots);
+    overlap_recbuffer = malloc(overlap_packet_size * overlap_slots);
+    overlap_started = malloc(sizeof(int) * overlap_slots);
+    overlap_comms = malloc(sizeof(MPI_Comm) * overlap_slots);
+    overlap_requests = malloc(sizeof(MPI_Request) * overlap_slots);
+    overlap_starts = malloc(sizeof(double) * overlap_slots);
+    overlap_ends = malloc(sizeof(double) * overlap_slots);
+    for(i = 0; i < overlap_slots; i++){
+        MPI_Comm_dup(MPI_COMM_WORLD, &overlap_comms[i]);
+        overlap_started[i] = 0;
+        overlap_ends[i] = -1;
+    }
+    MPI_Op_create((MPI_User_function *)add, 1, &overlap_op);
+    MPI_Type_contiguous(overlap_packet_size, MPI_PACKED, &overlap_type);
+    MPI_Type_commit(&overlap_type);
+
+    overlap_active = num_threads;
+    overlap_compute_end = -1;
+}
+
+/*
+ * Starts the reduction of the partial sum of a thread in its slot. Then, while any other
+ * thread of the process is still iterating, the thread drives the reduction forward.
+ * It returns -1 if the slot is not open (overlap mode disabled or already reduced),
+ * so the partial sum must be accumulated in the process as usual.
+ */
+int reduce_thread_pi_MPI(int thread_id, mpf_t local_thread_pi){
+    int flag, active;
+    double now;
+
+    if (thread_id >= overlap_slots || overlap_started[thread_id]) return -1;
+
+    now = MPI_Wtime();
+    pack(overlap_sendbuffer + thread_id * overlap_packet_size, local_thread_pi);
+    MPI_Ireduce(overlap_sendbuffer + thread_id * overlap_packet_size,
+                overlap_recbuffer + thread_id * overlap_packet_size, 1,
+                overlap_type, overlap_op, 0, overlap_comms[thread_id], &overlap_requests[thread_id]);
+    overlap_started[thread_id] = 1;
+    overlap_starts[thread_id] = now;
+
+    #pragma omp critical (overlap)
+    {
+        if (now > overlap_compute_end) overlap_compute_end = now;
+        overlap_active--;
+    }
+
+    //Progress of the reduction while the other threads compute (yielding the core to them)
+    do {
+        MPI_Test(&overlap_requests[thread_id], &flag, MPI_STATUS_IGNORE);
+        #pragma omp atomic read
+        active = overlap_active;
+        if (!flag && active > 0) sched_yield();
+    } while(!flag && active > 0);
+    if (flag) overlap_ends[thread_id] = MPI_Wtime();
+
+    return 0;
+}
+
+/*
+ * Reduces a zero in the slots without thread in this process, waits for every slot
+ * and adds their results to pi (only in process 0). It also gets the overlap achieved.
+ * IMPORTANT: It must be called by every process, after its parallel region
+ */
+void finish_overlap_MPI(mpf_t pi, int proc_id){
+    int i, num_procs, completed, * indices;
+    double now, end, local_times[2], times[2];
+    mpf_t slot_pi;
+
+    if (overlap_slots == 0) return;
+
+    mpf_init_set_ui(slot_pi, 0);
+    now = MPI_Wtime();
+    if (overlap_compute_end < 0) overlap_compute_end = now;
+    for(i = 0; i < overlap_slots; i++){
+        if (overlap_started[i]) continue;
+        pack(overlap_sendbuffer + i * overlap_packet_size, slot_pi);
+        MPI_Ireduce(overlap_sendbuffer + i * overlap_packet_size,
+                    overlap_recbuffer + i * overlap_packet_size, 1,
+                    overlap_type, overlap_op, 0, overlap_comms[i], &overlap_requests[i]);
+        overlap_starts[i] = now;
+    }
+
+    //Completion time of every reduction not completed yet
+    indices = malloc(sizeof(int) * overlap_slots);
+    while(1){
+        MPI_Waitsome(overlap_slots, overlap_requests, &completed, indices, MPI_STATUSES_IGNORE);
+        if (completed == MPI_UNDEFINED) break;
+        now = MPI_Wtime();
+        for(i = 0; i < completed; i++) overlap_ends[indices[i]] = now;
+    }
+    free(indices);
+
+    if (proc_id == 0){
+        for(i = 0; i < overlap_slots; i++){
+            unpack(overlap_recbuffer + i * overlap_packet_size, slot_pi);
+            mpf_add(pi, pi, slot_pi);
+        }
+    }
+
+    //Time of the reductions hidden by the computation and total time of the reductions
+    local_times[0] = 0;
+    local_times[1] = 0;
+    for(i = 0; i < overlap_slots; i++){
+        end = (overlap_ends[i] < overlap_compute_end) ? overlap_ends[i] : overlap_compute_end;
+        if (end > overlap_starts[i]) local_times[0] += end - overlap_starts[i];
+        local_times[1] += overlap_ends[i] - overlap_starts[i];
+    }
+    MPI_Reduce(local_times, times, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+    overlap_time = times[0] / num_procs;
+    overlap_reduction_time = times[1] / num_procs;
+
+    //Clear memory
+    for(i = 0; i < overlap_slots; i++){
+        MPI_Comm_free(&overlap_comms[i]);
+    }
+    MPI_Op_free(&overlap_op);
+    MPI_Type_free(&overlap_type);
+    free(overlap_sendbuffer);
+    free(overlap_recbuffer);
+    free(overlap_started);
+    free(overlap_comms);
+    free(overlap_requests);
+    free(overlap_starts);
+    free(overlap_ends);
+    mpf_clear(slot_pi);
+    overlap_slots = 0;
+}
+
+void print_overlap_MPI(){
+    double percentage;
+
+    percentage = (overlap_reduction_time > 0) ? 100 * overlap_time / overlap_reduction_time : 0;
+    printf("  Reduction overlapped with computation: %.2f%% (%f of %f seconds of reductions, mean of processes) \n",
+                percentage, overlap_time, overlap_reduction_time);
+}
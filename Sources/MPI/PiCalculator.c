@@ -6,49 +6,86 @@
 #include "../../Headers/MPI/BBP.h"
 #include "../../Headers/MPI/Bellard.h"
 #include "../../Headers/MPI/Chudnovsky.h"
+#include "../../Headers/MPI/OverlapMPI.h"
+#include "../../Headers/MPI/OutputMPI.h"
+#include "../../Headers/MPI/TimersMPI.h"
+#include "../../Headers/MPI/TraceMPI.h"
 #include "../../Headers/Common/Check_decimals.h"
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/Common/Output.h"
+#include "../../Headers/Common/Timers.h"
+#include "../../Headers/Common/Trace.h"
+#include "../../Headers/Common/Memory.h"
+#include "../../Headers/Common/Perf.h"
 
 double gettimeofday();
 
 
-void check_errors_MPI(int num_procs, int precision, int num_iterations, int num_threads, int proc_id, int algorithm){
+void check_errors_MPI(int num_procs, int precision, int num_iterations, int total_threads, int proc_id){
     if (precision <= 0){
         if(proc_id == 0) printf("  Precision should be greater than cero. \n\n");
         MPI_Finalize();
         exit(-1);
     } 
-    if (num_iterations < (num_threads * num_procs)){
+    if (num_iterations < total_threads){
         if(proc_id == 0){
-            printf("  The number of iterations required for the computation is too small to be solved with %d threads and %d procesess. \n", num_threads, num_procs);
+            printf("  The number of iterations required for the computation is too small to be solved with %d threads and %d procesess. \n", total_threads, num_procs);
             printf("  Try using a greater precision or lower threads/processes number. \n\n");
         }
         MPI_Finalize();
         exit(-1);
     }
-        if (algorithm == 2){ 
-            // Last version of Chudnovksy is more efficient when total threads are 2 or multiples of four
-            if ((num_procs * num_threads) > 2 && (num_procs * num_threads) % 4 != 0){
-                if (proc_id == 0){
-                    printf("  The last version of Chudnovksy is not eficient with %d processes and %d threads. \n", num_procs, num_threads);
-                    printf("  Try using 2 or multiples of four for the total threads\n\n");
-                }
-                MPI_Finalize();
-                exit(-1);
-            } 
-    }
 }
 
-void print_running_properties_MPI(int num_procs, int precision, int num_iterations, int num_threads){
+void print_running_properties_MPI(int num_procs, int precision, int num_iterations, int num_threads, int total_threads){
     printf("  Precision used: %d \n", precision);
     printf("  Iterations done: %d \n", num_iterations);
     printf("  Number of processes: %d\n", num_procs);
-    printf("  Number of threads (per process): %d\n", num_threads);
+    printf("  Number of threads (process 0): %d\n", num_threads);
+    printf("  Number of threads (all processes): %d\n", total_threads);
+}
+
+void print_distribution_MPI(){
+    char * distributions[] = {"equal", "weighted", "dynamic"};
+    printf("  Distribution of iterations: %s \n", distributions[run_options.distribution]);
+}
+
+/*
+ * Adds the GMP memory counters of all the processes in process 0 (see Memory).
+ * The peaks are the highest peak of the processes.
+ */
+void reduce_memory_MPI(int proc_id){
+    int phase, count;
+    long peaks[NUM_PHASES + 1];
+
+    collect_memory_counters();
+    count = sizeof(struct memory_counters) / sizeof(long);
+    for(phase = 0; phase < NUM_PHASES; phase++) peaks[phase] = memory_phases[phase].peak;
+    peaks[NUM_PHASES] = memory_total.peak;
+    MPI_Reduce((proc_id == 0) ? MPI_IN_PLACE : memory_phases, memory_phases, 
+                    NUM_PHASES * count, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce((proc_id == 0) ? MPI_IN_PLACE : &memory_total, &memory_total, 
+                    count, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce((proc_id == 0) ? MPI_IN_PLACE : peaks, peaks, NUM_PHASES + 1, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+    for(phase = 0; phase < NUM_PHASES; phase++) memory_phases[phase].peak = peaks[phase];
+    memory_total.peak = peaks[NUM_PHASES];
+}
+
+/*
+ * Adds the hardware counters of all the processes in process 0 (see Perf)
+ */
+void reduce_perf_MPI(int proc_id){
+    collect_perf_counters();
+    MPI_Reduce((proc_id == 0) ? MPI_IN_PLACE : perf_phases, perf_phases, 
+                    NUM_PHASES * NUM_PERF_EVENTS, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce((proc_id == 0) ? MPI_IN_PLACE : &perf_total, &perf_total, 
+                    NUM_PERF_EVENTS, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
 }
 
 void calculate_Pi_MPI(int num_procs, int proc_id, int algorithm, int precision, int num_threads){
-    double execution_time;
+    double execution_time, setup_start, reduction_time;
     struct timeval t1, t2;
-    int num_iterations, decimals_computed; 
+    int num_iterations, decimals_computed, total_threads, distributed_output; 
     mpf_t pi;    
 
     //Get init time 
@@ -57,40 +94,51 @@ void calculate_Pi_MPI(int num_procs, int proc_id, int algorithm, int precision,
     }
 
     //Set gmp float precision (in bits) and init pi
+    if (run_options.memory) start_memory_accounting();
+    if (run_options.perf) start_perf_counters();
+    reset_phases();
+    if (run_options.trace_file != NULL) start_trace();
+    setup_start = phase_clock();
     mpf_set_default_prec(precision * 8); 
     if (proc_id == 0){
         mpf_init_set_ui(pi, 0);
     }
+    phase_add(PHASE_SETUP, setup_start);
+
+    //Each process can use a different number of threads
+    MPI_Allreduce(&num_threads, &total_threads, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
     
     
     switch (algorithm)
     {
     case 0:
         num_iterations = precision * 0.84;
-        check_errors_MPI(num_procs, precision, num_iterations, num_threads, proc_id, algorithm);
+        check_errors_MPI(num_procs, precision, num_iterations, total_threads, proc_id);
         if (proc_id == 0){
             printf("  Algorithm: BBP (Last version)\n");
-            print_running_properties_MPI(num_procs, precision, num_iterations, num_threads);
+            print_running_properties_MPI(num_procs, precision, num_iterations, num_threads, total_threads);
+            print_distribution_MPI();
         } 
         BBP_algorithm_MPI(num_procs, proc_id, pi, num_iterations, num_threads);
         break;
 
     case 1:
         num_iterations = precision / 3;
-        check_errors_MPI(num_procs, precision, num_iterations, num_threads, proc_id, algorithm);
+        check_errors_MPI(num_procs, precision, num_iterations, total_threads, proc_id);
         if (proc_id == 0){
             printf("  Algorithm: Bellard \n");
-            print_running_properties_MPI(num_procs, precision, num_iterations, num_threads);
+            print_running_properties_MPI(num_procs, precision, num_iterations, num_threads, total_threads);
+            print_distribution_MPI();
         } 
         Bellard_algorithm_MPI(num_procs, proc_id, pi, num_iterations, num_threads);
         break;
 
     case 2:
         num_iterations = (precision + 14 - 1) / 14;  //Division por exceso
-        check_errors_MPI(num_procs, precision, num_iterations, num_threads, proc_id, algorithm);
+        check_errors_MPI(num_procs, precision, num_iterations, total_threads, proc_id);
         if (proc_id == 0){
             printf("  Algorithm: Chudnovsky (Without all factorials) \n");
-            print_running_properties_MPI(num_procs, precision, num_iterations, num_threads);
+            print_running_properties_MPI(num_procs, precision, num_iterations, num_threads, total_threads);
         } 
         Chudnovsky_algorithm_MPI(num_procs, proc_id, pi, num_iterations, num_threads);
         break;
@@ -108,14 +156,45 @@ void calculate_Pi_MPI(int num_procs, int proc_id, int algorithm, int precision,
         break;
     }
 
-    //Get time, check decimals, free pi and print the results
+    //Get time, write the decimals, check them, free pi and print the results
     if (proc_id == 0) {  
         gettimeofday(&t2, NULL);
         execution_time = ((t2.tv_sec - t1.tv_sec) * 1000000u +  t2.tv_usec - t1.tv_usec)/1.e6; 
-        decimals_computed = check_decimals(pi);
+    }
+    //A single decimal file is converted, checked and written by every process (see OutputMPI)
+    distributed_output = run_options.output_file != NULL && run_options.output_format == DECIMAL_FORMAT && 
+                            run_options.digits_per_file == 0;
+    if (distributed_output){
+        decimals_computed = write_decimals_MPI(run_options.output_file, pi, precision, proc_id, num_procs, num_threads);
+    }
+    if (proc_id == 0) {  
+        if (run_options.output_file != NULL && !distributed_output) decimals_computed = write_and_check_decimals(pi, precision);
+        else if (!distributed_output) decimals_computed = check_decimals(pi);
         mpf_clear(pi);
         printf("  Match the first %d decimals. \n", decimals_computed);
+        print_mismatch();
         printf("  Execution time: %f seconds. \n", execution_time);
+        if (run_options.overlap) print_overlap_MPI();
+        if (distributed_output) print_output_MPI(run_options.output_file, precision);
+    }
+
+    //Time of the phases in the slowest process and work of every thread
+    reduction_time = phase_seconds[PHASE_MPI_REDUCTION];
+    MPI_Reduce((proc_id == 0) ? MPI_IN_PLACE : phase_seconds, phase_seconds, NUM_PHASES, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (run_options.memory) reduce_memory_MPI(proc_id);
+    if (run_options.perf) reduce_perf_MPI(proc_id);
+    if (proc_id == 0){
+        print_phases();
+        print_memory(0);
+        print_perf(0);
+    }
+    print_imbalance_MPI(proc_id, num_procs, reduction_time, run_options.imbalance);
+    if (run_options.trace_file != NULL) save_trace_MPI(run_options.trace_file, proc_id, num_procs);
+    if (proc_id == 0) {  
+        if (run_options.report_file != NULL){
+            write_run_report(run_options.report_file, "MPI", algorithm, precision, num_iterations, num_procs, total_threads, 
+                                execution_time, decimals_computed);
+        }
         printf("\n");
     }
 
@@ -1,21 +1,48 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "mpi.h"
 #include "../../Headers/MPI/PiCalculator.h"
 #include "../../Headers/Common/Print_title.h"
+#include "../../Headers/Common/Options.h"
 
 
 int incorrect_params(char* exec_name){
     printf("  Number of params are not correct. Try with:\n");
-    printf("    mpirun -np num_procs %s algorithm precision num_threads\n", exec_name);
+    printf("    mpirun -np num_procs %s algorithm precision num_threads[,num_threads...] [options]\n", exec_name);
+    print_options_usage();
     printf("\n");
 }
 
+/*
+ * The number of threads can be the same for every process ("8")
+ * or a list with the threads of each process ("8,8,4").
+ * The processes after the end of the list use its last value.
+ */
+int get_num_threads(char * param, int proc_id){
+    int i, num_threads;
+    char * value, * next;
+
+    value = param;
+    for(i = 0; i < proc_id; i++){
+        next = strchr(value, ',');
+        if (next == NULL) break;
+        value = next + 1;
+    }
+    num_threads = atoi(value);
+
+    return (num_threads <= 0) ? 1 : num_threads;
+}
+
 int main(int argc, char **argv){    
-    int num_procs, proc_id;
+    int num_procs, proc_id, options_error, thread_required, thread_support, min_thread_support;
+
+    //The options are read first, as the overlap mode needs every thread doing MPI calls
+    options_error = (argc < 4) ? -1 : parse_options(argc, argv, 4);
+    thread_required = (run_options.overlap) ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED;
 
-    //Init MPI
-    MPI_Init(&argc, &argv);
+    //Init MPI (only the master thread of each process does MPI calls, unless overlap mode)
+    MPI_Init_thread(&argc, &argv, thread_required, &thread_support);
     MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
     MPI_Comm_rank(MPI_COMM_WORLD, &proc_id); 
 
@@ -27,15 +54,22 @@ int main(int argc, char **argv){
     }
 
     //Check the number of parameters are correct
-    if(argc != 4){
+    if(options_error != 0){
         incorrect_params(argv[0]);
         exit(-1);
     }
 
+    //Without MPI_THREAD_MULTIPLE in every process the threads can not reduce by themselves
+    MPI_Allreduce(&thread_support, &min_thread_support, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if(run_options.overlap && min_thread_support < MPI_THREAD_MULTIPLE){
+        if(proc_id == 0) printf("  MPI_THREAD_MULTIPLE is not supported, overlap mode disabled. \n\n");
+        run_options.overlap = 0;
+    }
+
     //Take operation, precision and number of threads from params
     int algorithm = atoi(argv[1]);    
     int precision = atoi(argv[2]);
-    int num_threads = (atoi(argv[3]) <= 0) ? 1 : atoi(argv[3]);
+    int num_threads = get_num_threads(argv[3], proc_id);
 
     //Compute Pi
     calculate_Pi_MPI(num_procs, proc_id, algorithm, precision, num_threads);
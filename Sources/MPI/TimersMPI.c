@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "../../Headers/Common/Timers.h"
+
+
+/************************************************************************************
+ * Load imbalance of all the processes                                              *
+ * The work of the threads of every process (see Timers) is gathered in process 0,  *
+ * which prints the imbalance factor of all the threads and of the processes, with  *
+ * the time of each process in the reduction of the sums (and the work of every     *
+ * thread with --imbalance).                                                        *
+ *                                                                                  *
+ ************************************************************************************/
+
+
+/*
+ * Gathers the work of the threads of every process and the time of each process in 
+ * the reduction of the sums (reduction_time) in process 0, which prints the imbalance
+ * factor of all the threads and of the processes (the time of a process is the busy and
+ * wait time of its slowest thread) and, if detailed is not 0, the work of every thread.
+ * It must be called by every process.
+ */
+void print_imbalance_MPI(int proc_id, int num_procs, double reduction_time, int detailed){
+    int proc, thread, bytes, total_threads, * counts, * displs;
+    double proc_time, max_time, sum_times, * reduction_times;
+    struct thread_work * threads, * proc_threads;
+
+    counts = malloc(sizeof(int) * num_procs);
+    displs = malloc(sizeof(int) * num_procs);
+    reduction_times = malloc(sizeof(double) * num_procs);
+    bytes = work_num_threads * sizeof(struct thread_work);
+    MPI_Gather(&bytes, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Gather(&reduction_time, 1, MPI_DOUBLE, reduction_times, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    total_threads = 0;
+    if (proc_id == 0){
+        for(proc = 0; proc < num_procs; proc++){
+            displs[proc] = total_threads * sizeof(struct thread_work);
+            total_threads += counts[proc] / sizeof(struct thread_work);
+        }
+    }
+    threads = malloc(sizeof(struct thread_work) * (total_threads + 1));
+    MPI_Gatherv(work_threads, bytes, MPI_BYTE, threads, counts, displs, MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    //From bytes to threads
+    if (proc_id == 0){
+        for(proc = 0; proc < num_procs; proc++){
+            counts[proc] /= sizeof(struct thread_work);
+            displs[proc] /= sizeof(struct thread_work);
+        }
+    }
+
+    if (proc_id == 0 && total_threads > 0){
+        printf("  Load imbalance of the threads (max/mean busy time): %f \n", get_imbalance(threads, total_threads));
+        printf("      %-7s %-7s %-13s %-13s %-13s \n", "Process", "Threads", "Imbalance", "Time", "Reduction");
+        max_time = 0;
+        sum_times = 0;
+        for(proc = 0; proc < num_procs; proc++){
+            proc_threads = threads + displs[proc];
+            proc_time = 0;
+            for(thread = 0; thread < counts[proc]; thread++){
+                if (proc_threads[thread].busy + proc_threads[thread].wait > proc_time){
+                    proc_time = proc_threads[thread].busy + proc_threads[thread].wait;
+                }
+            }
+            if (proc_time > max_time) max_time = proc_time;
+            sum_times += proc_time;
+            printf("      %-7d %-7d %-13f %-13f %-13f \n", proc, counts[proc], get_imbalance(proc_threads, counts[proc]), 
+                        proc_time, reduction_times[proc]);
+        }
+        printf("  Load imbalance of the processes (max/mean time): %f \n", (sum_times > 0) ? max_time * num_procs / sum_times : 1);
+        if (detailed){
+            printf("      %-7s %-7s %-11s %-32s %-10s %-10s \n", "Process", "Thread", "Iterations", "Range", "Busy", "Wait");
+            for(proc = 0; proc < num_procs; proc++){
+                print_thread_work(threads + displs[proc], counts[proc], proc);
+            }
+        }
+    }
+
+    //Clear memory
+    free(counts);
+    free(displs);
+    free(reduction_times);
+    free(threads);
+}
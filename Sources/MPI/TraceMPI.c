@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "../../Headers/Common/Timers.h"
+#include "../../Headers/Common/Trace.h"
+
+#define CLOCK_PINGS 8                       // Round trips to measure the offset of each clock
+
+
+/************************************************************************************
+ * Timeline of all the processes (--trace file)                                     *
+ * The monotonic clocks of the nodes start at different times, so the offset of the *
+ * clock of every process to the clock of process 0 is measured with round trips:   *
+ * the process answers with its clock, and its offset is its clock minus the middle *
+ * of the round trip in process 0 (the shortest round trip is the most accurate).   *
+ * The events of every process are corrected with its offset and gathered in        *
+ * process 0, which saves them in one trace (see Trace).                            *
+ *                                                                                  *
+ ************************************************************************************/
+
+
+/*
+ * Returns the offset of the clock of this process (phase_clock) to the clock of process 0.
+ * IMPORTANT: It must be called by every process
+ */
+double get_clock_offset_MPI(int proc_id, int num_procs){
+    int proc, ping;
+    double sent, received, remote, round_trip, best, offset;
+
+    offset = 0;
+    if (proc_id == 0){
+        for(proc = 1; proc < num_procs; proc++){
+            best = -1;
+            for(ping = 0; ping < CLOCK_PINGS; ping++){
+                sent = phase_clock();
+                MPI_Send(&sent, 1, MPI_DOUBLE, proc, 0, MPI_COMM_WORLD);
+                MPI_Recv(&remote, 1, MPI_DOUBLE, proc, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                received = phase_clock();
+                round_trip = received - sent;
+                if (best < 0 || round_trip < best){
+                    best = round_trip;
+                    offset = remote - (sent + received) / 2;
+                }
+            }
+            MPI_Send(&offset, 1, MPI_DOUBLE, proc, 0, MPI_COMM_WORLD);
+        }
+        offset = 0;
+    } else {
+        for(ping = 0; ping < CLOCK_PINGS; ping++){
+            MPI_Recv(&sent, 1, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            remote = phase_clock();
+            MPI_Send(&remote, 1, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
+        }
+        MPI_Recv(&offset, 1, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+    return offset;
+}
+
+/*
+ * Gathers the events of every process in process 0, which saves them in file_name.
+ * IMPORTANT: It must be called by every process
+ */
+void save_trace_MPI(char * file_name, int proc_id, int num_procs){
+    int proc, bytes, total_bytes, * counts, * displs;
+    long num_events;
+    double offset;
+    struct trace_event * events, * all_events;
+
+    offset = get_clock_offset_MPI(proc_id, num_procs);
+    num_events = collect_trace(&events, proc_id, offset);
+
+    counts = malloc(sizeof(int) * num_procs);
+    displs = malloc(sizeof(int) * num_procs);
+    bytes = num_events * sizeof(struct trace_event);
+    MPI_Gather(&bytes, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    total_bytes = 0;
+    if (proc_id == 0){
+        for(proc = 0; proc < num_procs; proc++){
+            displs[proc] = total_bytes;
+            total_bytes += counts[proc];
+        }
+    }
+    all_events = malloc(total_bytes + sizeof(struct trace_event));
+    MPI_Gatherv(events, bytes, MPI_BYTE, all_events, counts, displs, MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    if (proc_id == 0){
+        num_events = total_bytes / sizeof(struct trace_event);
+        if (write_trace(file_name, all_events, num_events) == 0){
+            printf("  Trace of %ld events of %d processes written to %s \n", num_events, num_procs, file_name);
+        } else {
+            printf("  Trace file %s could not be written \n", file_name);
+        }
+    }
+
+    //Clear memory
+    free(counts);
+    free(displs);
+    free(events);
+    free(all_events);
+}
@@ -0,0 +1,423 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <gmp.h>
+#include "mpi.h"
+#include "../../Headers/Sequential/BBP.h"
+#include "../../Headers/Sequential/BBP_v1.h"
+#include "../../Headers/Sequential/Bellard_v1.h"
+#include "../../Headers/Sequential/Chudnovsky.h"
+#include "../../Headers/Sequential/Chudnovsky_v1.h"
+#include "../../Headers/OMP/Chudnovsky.h"
+#include "../../Headers/MPI/OperationsMPI.h"
+#include "../../Headers/Benchmark/Benchmark.h"
+#include "../../Headers/Microbenchmark/Microbenchmark.h"
+
+#ifndef GIT_REVISION
+#define GIT_REVISION "unknown"              // Set by compile.sh
+#endif
+
+#define A 13591409
+#define B 545140134
+#define C 640320
+#define MAX_CALLS (1L << 30)                // Limit of the calls of each sample
+#define NUM_VALUES 9
+
+
+/************************************************************************************
+ * Microbenchmark of the kernels                                                    *
+ * Every kernel (an iteration of the formulas, the seeds of Chudnovsky and the      *
+ * pack, unpack and add of the MPI reductions) is timed alone, with the values of   *
+ * the iteration in the middle of its algorithm for each precision.                 *
+ *                                                                                  *
+ * The process is pinned to one processor. The calls of each sample are doubled     *
+ * until the sample takes --min-time seconds (these first samples are the warmup),  *
+ * and then --repetitions samples with that number of calls are measured, each one  *
+ * from the values of the setup of the kernel. The median time per call is divided  *
+ * by the limbs of the values, so the ns/limb of a kernel can be compared between   *
+ * revisions and precisions.                                                        *
+ *                                                                                  *
+ ************************************************************************************/
+
+struct kernel_state {
+    int n;
+    int dep_a, dep_b;                       // Integer dependencies of Bellard
+    mpf_t pi, values[NUM_VALUES];
+    mpf_t factorials[3];
+    char * buffers[3];                      // Packed values of the MPI operations
+    int sign;                               // Operand of the next add (buffers[0] or buffers[2])
+    int length;
+    MPI_Datatype type;
+};
+
+struct microbenchmark_kernel {
+    char * name;
+    int algorithm;                          // Algorithm whose iterations give n (see benchmark_iterations)
+    void (* setup)(struct kernel_state *);  // NULL if the kernel does not need values
+    void (* run)(struct kernel_state *);
+};
+
+
+/*
+ * Stores a value with all the limbs of the precision in value (1/d)
+ */
+void set_full_value(mpf_t value, unsigned long d){
+    mpf_set_ui(value, 1);
+    mpf_div_ui(value, value, d);
+}
+
+void setup_BBP(struct kernel_state * state){
+    mpf_set_d(state -> values[5], 0.0625);
+    mpf_pow_ui(state -> values[0], state -> values[5], state -> n);   // dep_m = (1/16)^n
+}
+
+void run_BBP(struct kernel_state * state){
+    BBP_iteration(state -> pi, state -> n, state -> values[0], state -> values[1], state -> values[2],
+                    state -> values[3], state -> values[4], state -> values[5]);
+}
+
+void setup_BBP_v1(struct kernel_state * state){
+    mpf_set_d(state -> values[0], 0.0625);                             // quotient = 1/16
+}
+
+void run_BBP_v1(struct kernel_state * state){
+    BBP_iteration_v1(state -> pi, state -> n, state -> values[0]);
+}
+
+void setup_Bellard(struct kernel_state * state){
+    mpf_set_ui(state -> values[0], 1);
+    mpf_div_2exp(state -> values[0], state -> values[0], 10 * state -> n); // m = (-1)^n / 1024^n
+    if (state -> n % 2 != 0) mpf_neg(state -> values[0], state -> values[0]);
+    state -> dep_a = 4 * state -> n;
+    state -> dep_b = 10 * state -> n;
+}
+
+void run_Bellard(struct kernel_state * state){
+    Bellard_iteration(state -> pi, state -> n, state -> values[0], state -> values[1], state -> values[2],
+                        state -> values[3], state -> values[4], state -> values[5], state -> values[6],
+                        state -> values[7], state -> values[8], state -> dep_a, state -> dep_b);
+}
+
+void setup_Chudnovsky(struct kernel_state * state){
+    init_dep_a(state -> values[0], state -> n);                         // dep_a = (6n)! / ((n!)^3 (3n)!)
+    mpf_set_ui(state -> values[1], C);
+    mpf_neg(state -> values[1], state -> values[1]);
+    mpf_pow_ui(state -> values[1], state -> values[1], 3 * state -> n); // dep_b = (-640320)^3n
+    mpf_set_ui(state -> values[2], B);
+    mpf_mul_ui(state -> values[2], state -> values[2], state -> n);
+    mpf_add_ui(state -> values[2], state -> values[2], A);              // dep_c = 545140134n + 13591409
+}
+
+void run_Chudnovsky(struct kernel_state * state){
+    Chudnovsky_iteration(state -> pi, state -> n, state -> values[0], state -> values[1],
+                            state -> values[2], state -> values[3]);
+}
+
+void setup_Chudnovsky_v1(struct kernel_state * state){
+    get_factorials(state -> factorials, state -> n);
+    mpf_set(state -> values[0], state -> factorials[2]);                // (6n)!
+    mpf_pow_ui(state -> values[1], state -> factorials[0], 3);          // (n!)^3
+    mpf_set(state -> values[2], state -> factorials[1]);                // (3n)!
+    clear_factorials(state -> factorials);
+    mpf_set_ui(state -> values[3], C);
+    mpf_neg(state -> values[3], state -> values[3]);
+    mpf_pow_ui(state -> values[3], state -> values[3], 3 * state -> n); // (-640320)^3n
+    mpf_set_ui(state -> values[4], B);
+    mpf_mul_ui(state -> values[4], state -> values[4], state -> n);
+    mpf_add_ui(state -> values[4], state -> values[4], A);
+}
+
+void run_Chudnovsky_v1(struct kernel_state * state){
+    Chudnovsky_iteration_v1(state -> pi, state -> n, state -> values[0], state -> values[1], state -> values[2],
+                                state -> values[3], state -> values[4], state -> values[5], state -> values[6]);
+}
+
+void run_init_dep_a(struct kernel_state * state){
+    init_dep_a(state -> values[0], state -> n);
+}
+
+/*
+ * The factorials are initialized by get_factorials, so they are also cleared
+ */
+void run_get_factorials(struct kernel_state * state){
+    get_factorials(state -> factorials, state -> n);
+    clear_factorials(state -> factorials);
+}
+
+void setup_MPI(struct kernel_state * state){
+    set_full_value(state -> values[0], 3);
+    set_full_value(state -> values[1], 7);
+    mpf_neg(state -> values[2], state -> values[0]);
+    pack(state -> buffers[0], state -> values[0]);
+    pack(state -> buffers[1], state -> values[1]);
+    pack(state -> buffers[2], state -> values[2]);
+    state -> sign = 0;
+    state -> length = 1;
+    state -> type = MPI_PACKED;
+}
+
+void run_pack(struct kernel_state * state){
+    pack(state -> buffers[0], state -> values[0]);
+}
+
+void run_unpack(struct kernel_state * state){
+    unpack(state -> buffers[0], state -> values[1]);
+}
+
+/*
+ * The sum is stored in buffers[1], so 1/3 and -1/3 are added alternately
+ * to keep the operands of every call (1/7 and 1/7 + 1/3)
+ */
+void run_add(struct kernel_state * state){
+    add(state -> buffers[state -> sign], state -> buffers[1], &state -> length, &state -> type);
+    state -> sign = 2 - state -> sign;
+}
+
+struct microbenchmark_kernel microbenchmark_kernels[NUM_KERNELS] = {
+    {"BBP_iteration", 1, setup_BBP, run_BBP},
+    {"BBP_iteration_v1", 0, setup_BBP_v1, run_BBP_v1},
+    {"Bellard_iteration", 3, setup_Bellard, run_Bellard},
+    {"Chudnovsky_iteration", 5, setup_Chudnovsky, run_Chudnovsky},
+    {"Chudnovsky_iteration_v1", 4, setup_Chudnovsky_v1, run_Chudnovsky_v1},
+    {"init_dep_a", 5, NULL, run_init_dep_a},
+    {"get_factorials", 4, NULL, run_get_factorials},
+    {"pack", 5, setup_MPI, run_pack},
+    {"unpack", 5, setup_MPI, run_unpack},
+    {"add", 5, setup_MPI, run_add}
+};
+
+
+/*
+ * Reads the options, given as pairs "--name value", with their default values.
+ * It returns 0 if every option is correct and -1 otherwise.
+ */
+int parse_microbenchmark_options(int argc, char ** argv, struct microbenchmark_options * options){
+    int i, k;
+    char * name, * value;
+
+    options -> num_kernels = parse_list("0-9", options -> kernels);
+    options -> num_precisions = parse_list("1000,10000,100000", options -> precisions);
+    options -> repetitions = 11;
+    options -> min_time = 0.01;
+    options -> cpu = sched_getcpu();
+    options -> csv_file = NULL;
+    options -> json_file = NULL;
+
+    for(i = 1; i < argc; i++){
+        name = argv[i];
+        if (i + 1 >= argc) return -1;
+        value = argv[++i];
+
+        if (strcmp(name, "--kernels") == 0){
+            options -> num_kernels = parse_list(value, options -> kernels);
+            if (options -> num_kernels <= 0) return -1;
+            for(k = 0; k < options -> num_kernels; k++){
+                if (options -> kernels[k] < 0 || options -> kernels[k] >= NUM_KERNELS) return -1;
+            }
+
+        } else if (strcmp(name, "--precisions") == 0){
+            options -> num_precisions = parse_list(value, options -> precisions);
+            if (options -> num_precisions <= 0) return -1;
+            for(k = 0; k < options -> num_precisions; k++){
+                if (options -> precisions[k] <= 0) return -1;
+            }
+
+        } else if (strcmp(name, "--repetitions") == 0){
+            options -> repetitions = atoi(value);
+            if (options -> repetitions <= 0) return -1;
+
+        } else if (strcmp(name, "--min-time") == 0){
+            options -> min_time = atof(value);
+            if (options -> min_time <= 0) return -1;
+
+        } else if (strcmp(name, "--cpu") == 0){
+            options -> cpu = atoi(value);
+
+        } else if (strcmp(name, "--csv") == 0){
+            options -> csv_file = value;
+
+        } else if (strcmp(name, "--json") == 0){
+            options -> json_file = value;
+
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void print_microbenchmark_usage(){
+    int k;
+
+    printf("  Options: \n");
+    printf("    --kernels list -> Kernels to time, as \"0,2,4\" or \"0-9\" (all by default): \n");
+    for(k = 0; k < NUM_KERNELS; k++) printf("          %d -> %s \n", k, microbenchmark_kernels[k].name);
+    printf("    --precisions list -> Precisions to time (1000,10000,100000 by default) \n");
+    printf("    --repetitions n -> Measured samples of each case (11 by default) \n");
+    printf("    --min-time seconds -> Minimum time of each sample (0.01 by default) \n");
+    printf("    --cpu n -> Processor where the process is pinned (the current one by default, -1 = not pinned) \n");
+    printf("    --csv file -> Save the results as CSV \n");
+    printf("    --json file -> Save the results as JSON \n");
+}
+
+/*
+ * Pins this process to the processor. It returns 0, or -1 if it could not be pinned.
+ */
+int pin_to_cpu(int cpu){
+    cpu_set_t set;
+
+    if (cpu < 0) return -1;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set);
+}
+
+/*
+ * Calls the kernel calls times and returns the elapsed seconds
+ */
+double time_kernel(struct microbenchmark_kernel * kernel, struct kernel_state * state, long calls){
+    long call;
+    struct timespec t1, t2;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    for(call = 0; call < calls; call++) kernel -> run(state);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    return (t2.tv_sec - t1.tv_sec) + (t2.tv_nsec - t1.tv_nsec) / 1.e9;
+}
+
+/*
+ * Times the kernel at the precision (see the header of this file)
+ */
+void measure_kernel(struct kernel_result * result, struct microbenchmark_options * options, double * times){
+    int i, packet_size;
+    double elapsed;
+    struct microbenchmark_kernel * kernel;
+    struct kernel_state state;
+
+    kernel = &microbenchmark_kernels[result -> kernel];
+    mpf_set_default_prec(result -> precision * 8);
+    result -> n = benchmark_iterations(kernel -> algorithm, result -> precision) / 2;
+
+    //State of the kernel
+    memset(&state, 0, sizeof(state));
+    state.n = result -> n;
+    mpf_init_set_ui(state.pi, 0);
+    for(i = 0; i < NUM_VALUES; i++) mpf_init(state.values[i]);
+    result -> limbs = state.pi -> _mp_prec + 1;
+    packet_size = 8 + sizeof(mp_exp_t) + ((state.pi -> _mp_prec + 1) * sizeof(mp_limb_t));
+    state.buffers[0] = malloc(packet_size);
+    state.buffers[1] = malloc(packet_size);
+    state.buffers[2] = malloc(packet_size);
+    if (kernel -> setup != NULL) kernel -> setup(&state);
+
+    //Warmup: calls of each sample
+    result -> calls = 1;
+    while((elapsed = time_kernel(kernel, &state, result -> calls)) < options -> min_time && result -> calls < MAX_CALLS){
+        result -> calls *= 2;
+    }
+
+    for(i = 0; i < options -> repetitions; i++){
+        if (kernel -> setup != NULL) kernel -> setup(&state);
+        times[i] = time_kernel(kernel, &state, result -> calls) * 1.e9 / result -> calls;
+    }
+    get_statistics(&result -> time, times, options -> repetitions);
+
+    //Clear memory
+    mpf_clear(state.pi);
+    for(i = 0; i < NUM_VALUES; i++) mpf_clear(state.values[i]);
+    free(state.buffers[0]);
+    free(state.buffers[1]);
+    free(state.buffers[2]);
+}
+
+void write_kernels_csv(char * file_name, struct kernel_result * results, int num_results,
+                            struct microbenchmark_options * options, char * cpu){
+    int i;
+    FILE * file;
+
+    file = fopen(file_name, "w");
+    if (file == NULL){
+        printf("  %s could not be written \n", file_name);
+        return;
+    }
+    fprintf(file, "revision,cpu,pinned_cpu,gmp,repetitions,kernel,name,precision,n,limbs,calls,"
+                    "median_ns,min_ns,max_ns,mean_ns,stddev_ns,ns_per_limb\n");
+    for(i = 0; i < num_results; i++){
+        fprintf(file, "%s,\"%s\",%d,%s,%d,%d,%s,%d,%d,%ld,%ld,%f,%f,%f,%f,%f,%f\n", GIT_REVISION, cpu, options -> cpu,
+                    gmp_version, options -> repetitions, results[i].kernel, microbenchmark_kernels[results[i].kernel].name,
+                    results[i].precision, results[i].n, results[i].limbs, results[i].calls, results[i].time.median,
+                    results[i].time.min, results[i].time.max, results[i].time.mean, results[i].time.stddev,
+                    results[i].time.median / results[i].limbs);
+    }
+    fclose(file);
+}
+
+void write_kernels_json(char * file_name, struct kernel_result * results, int num_results,
+                            struct microbenchmark_options * options, char * cpu){
+    int i;
+    FILE * file;
+
+    file = fopen(file_name, "w");
+    if (file == NULL){
+        printf("  %s could not be written \n", file_name);
+        return;
+    }
+    fprintf(file, "{\n  \"revision\": \"%s\",\n  \"cpu\": \"%s\",\n  \"pinned_cpu\": %d,\n  \"gmp\": \"%s\",\n",
+                GIT_REVISION, cpu, options -> cpu, gmp_version);
+    fprintf(file, "  \"repetitions\": %d,\n  \"min_time\": %f,\n  \"results\": [\n", options -> repetitions, options -> min_time);
+    for(i = 0; i < num_results; i++){
+        fprintf(file, "    {\"kernel\": %d, \"name\": \"%s\", \"precision\": %d, \"n\": %d, \"limbs\": %ld, \"calls\": %ld, "
+                        "\"median_ns\": %f, \"min_ns\": %f, \"max_ns\": %f, \"mean_ns\": %f, \"stddev_ns\": %f, "
+                        "\"ns_per_limb\": %f}%s\n", results[i].kernel, microbenchmark_kernels[results[i].kernel].name,
+                    results[i].precision, results[i].n, results[i].limbs, results[i].calls, results[i].time.median,
+                    results[i].time.min, results[i].time.max, results[i].time.mean, results[i].time.stddev,
+                    results[i].time.median / results[i].limbs, (i < num_results - 1) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+}
+
+void run_microbenchmark(struct microbenchmark_options * options){
+    int k, p, num_results;
+    double * times;
+    char cpu[256];
+    struct kernel_result * results, * result;
+
+    get_cpu_model(cpu, sizeof(cpu));
+    if (pin_to_cpu(options -> cpu) != 0) options -> cpu = -1;
+    printf("  Revision: %s \n", GIT_REVISION);
+    printf("  Processor: %s (pinned to %d) \n", cpu, options -> cpu);
+    printf("  Repetitions: %d, minimum time of each sample: %f seconds \n", options -> repetitions, options -> min_time);
+    printf("\n");
+    printf("  %-24s %-9s %-8s %-7s %-9s %-14s %-8s %-10s \n",
+                "Kernel", "Precision", "n", "Limbs", "Calls", "Median (ns)", "Stddev", "ns/limb");
+
+    results = malloc(sizeof(struct kernel_result) * options -> num_kernels * options -> num_precisions);
+    times = malloc(sizeof(double) * options -> repetitions);
+    num_results = 0;
+    for(k = 0; k < options -> num_kernels; k++){
+        for(p = 0; p < options -> num_precisions; p++){
+            result = &results[num_results++];
+            result -> kernel = options -> kernels[k];
+            result -> precision = options -> precisions[p];
+            measure_kernel(result, options, times);
+            printf("  %-24s %-9d %-8d %-7ld %-9ld %-14.1f %6.2f%%  %-10.3f \n", microbenchmark_kernels[result -> kernel].name,
+                        result -> precision, result -> n, result -> limbs, result -> calls, result -> time.median,
+                        100 * result -> time.stddev / result -> time.mean, result -> time.median / result -> limbs);
+            fflush(stdout);
+        }
+    }
+    printf("\n");
+
+    if (options -> csv_file != NULL) write_kernels_csv(options -> csv_file, results, num_results, options, cpu);
+    if (options -> json_file != NULL) write_kernels_json(options -> json_file, results, num_results, options, cpu);
+
+    //Clear memory
+    free(results);
+    free(times);
+}
@@ -0,0 +1,33 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "../../Headers/Benchmark/Benchmark.h"
+#include "../../Headers/Microbenchmark/Microbenchmark.h"
+#include "../../Headers/Common/Print_title.h"
+
+
+int main(int argc, char **argv){
+    struct microbenchmark_options options;
+
+    //MPI is only needed by pack, unpack and add (a single process)
+    MPI_Init(&argc, &argv);
+
+    //Print title
+    print_PiDecimals_title();
+    printf("  Microbenchmark of the kernels! \n");
+    printf("\n");
+
+    if (parse_microbenchmark_options(argc, argv, &options) != 0){
+        printf("  Params are not correct. Try with:\n");
+        printf("    %s [options] \n", argv[0]);
+        print_microbenchmark_usage();
+        printf("\n");
+        MPI_Finalize();
+        exit(-1);
+    }
+
+    run_microbenchmark(&options);
+
+    MPI_Finalize();
+    exit(0);
+}
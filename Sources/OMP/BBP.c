@@ -3,6 +3,8 @@
 #include <gmp.h>
 #include <omp.h>
 #include "../../Headers/Sequential/BBP.h"
+#include "../../Headers/Common/Checkpoint.h"
+#include "../../Headers/Common/Timers.h"
 
 
 #define QUOTIENT 0.0625
@@ -41,20 +43,25 @@
  * Multiple threads can be used
  * The number of iterations is divided in blocks, 
  * so each thread calculates a part of Pi.  
+ * With --checkpoint its state is saved periodically (see Checkpoint)
  */
 void BBP_algorithm_OMP(mpf_t pi, int num_iterations, int num_threads){
     mpf_t quotient; 
 
     mpf_init_set_d(quotient, QUOTIENT);         // quotient = (1 / 16)   
 
+    init_checkpoint(CHECKPOINT_BBP, num_iterations, num_threads, 2);
+
     //Set the number of threads 
     omp_set_num_threads(num_threads);
 
     #pragma omp parallel 
     {
-        int thread_id, i, block_size, block_start, block_end;
+        int thread_id, i, slot, block_size, block_start, block_end;
+        double start, busy, wait;
         mpf_t local_pi, dep_m, quot_a, quot_b, quot_c, quot_d, aux;
 
+        start = phase_clock();
         thread_id = omp_get_thread_num();
         block_size = (num_iterations + num_threads - 1) / num_threads;
         block_start = thread_id * block_size;
@@ -63,24 +70,40 @@ void BBP_algorithm_OMP(mpf_t pi, int num_iterations, int num_threads){
 
         mpf_init_set_ui(local_pi, 0);               // private thread pi
         mpf_init(dep_m);
-        mpf_pow_ui(dep_m, quotient, block_start);    // m = (1/16)^n                  
         mpf_inits(quot_a, quot_b, quot_c, quot_d, aux, NULL);
 
+        //State saved in the checkpoints (see Checkpoint)
+        mpf_ptr state[] = {local_pi, dep_m};
+        slot = resume_checkpoint(block_start, &block_start, &block_end, state);
+        if (slot < 0){
+            mpf_pow_ui(dep_m, quotient, block_start);    // m = (1/16)^n                  
+            slot = open_checkpoint_slot(block_start, 1, block_start, block_end, NULL);
+        }
+        busy = phase_add(PHASE_INIT, start);
+
         //First Phase -> Working on a local variable        
+        start = phase_clock();
         #pragma omp parallel for 
             for(i = block_start; i < block_end; i++){
+                checkpoint_poll(slot, i, state);
                 BBP_iteration(local_pi, i, dep_m, quot_a, quot_b, quot_c, quot_d, aux);
                 // Update dependencies:  
                 mpf_mul(dep_m, dep_m, quotient);
             }
+        checkpoint_done(slot, state);
+        busy += phase_add(PHASE_SERIES, start);
 
         //Second Phase -> Accumulate the result in the global variable
+        start = phase_clock();
         #pragma omp critical
         mpf_add(pi, pi, local_pi);
+        wait = phase_add(PHASE_THREAD_REDUCTION, start);
+        record_thread_work(thread_id, block_start, block_end, 1, busy, wait);
 
         //Clear thread memory
         mpf_clears(local_pi, dep_m, quot_a, quot_b, quot_c, quot_d, aux, NULL);   
     }
+    finish_checkpoint();
         
     //Clear memory
     mpf_clear(quotient);
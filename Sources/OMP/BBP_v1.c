@@ -3,6 +3,7 @@
 #include <gmp.h>
 #include <omp.h>
 #include "../../Headers/Sequential/BBP_v1.h"
+#include "../../Headers/Common/Timers.h"
 
 
 #define QUOTIENT 0.0625
@@ -46,20 +47,26 @@ void BBP_algorithm_v1_OMP(mpf_t pi, int num_iterations, int num_threads){
 
     #pragma omp parallel private(thread_id, i)
     {
+        double start, busy, wait;
         mpf_t local_pi;
 
         thread_id = omp_get_thread_num();
         mpf_init_set_ui(local_pi, 0);   // private thread pi
         
         //First Phase -> Working on a local variable        
+        start = phase_clock();
         #pragma omp parallel for 
             for(i = thread_id; i < num_iterations; i+=num_threads){
                 BBP_iteration_v1(local_pi, i, quotient);    
             }
+        busy = phase_add(PHASE_SERIES, start);
 
         //Second Phase -> Accumulate the result in the global variable
+        start = phase_clock();
         #pragma omp critical
         mpf_add(pi, pi, local_pi);
+        wait = phase_add(PHASE_THREAD_REDUCTION, start);
+        record_thread_work(thread_id, thread_id, num_iterations, num_threads, busy, wait);
 
         //Clear thread memory
         mpf_clear(local_pi);   
@@ -3,6 +3,7 @@
 #include <gmp.h>
 #include <omp.h>
 #include "../../Headers/Sequential/Bellard_v1.h"
+#include "../../Headers/Common/Timers.h"
 
 
 
@@ -46,6 +47,7 @@
  * so each thread calculates a part of Pi.  
  */
 void Bellard_algorithm_OMP(mpf_t pi, int num_iterations, int num_threads){
+    double start;
     mpf_t ONE;
     mpf_init_set_ui(ONE, 1);
 
@@ -55,6 +57,7 @@ void Bellard_algorithm_OMP(mpf_t pi, int num_iterations, int num_threads){
     #pragma omp parallel 
     {
         int thread_id, i, dep_a, dep_b, jump_dep_a, jump_dep_b, next_i;
+        double start, busy, wait;
         mpf_t local_pi, dep_m, a, b, c, d, e, f, g, aux;
 
         thread_id = omp_get_thread_num();
@@ -70,6 +73,7 @@ void Bellard_algorithm_OMP(mpf_t pi, int num_iterations, int num_threads){
         mpf_inits(a, b, c, d, e, f, g, aux, NULL);
 
         //First Phase -> Working on a local variable
+        start = phase_clock();
         #pragma omp parallel for 
             for(i = thread_id; i < num_iterations; i+=num_threads){
                 Bellard_iteration(local_pi, i, dep_m, a, b, c, d, e, f, g, aux, dep_a, dep_b);
@@ -81,16 +85,22 @@ void Bellard_algorithm_OMP(mpf_t pi, int num_iterations, int num_threads){
                 dep_a += jump_dep_a;
                 dep_b += jump_dep_b;  
             }
+        busy = phase_add(PHASE_SERIES, start);
 
         //Second Phase -> Accumulate the result in the global variable
+        start = phase_clock();
         #pragma omp critical
         mpf_add(pi, pi, local_pi);
+        wait = phase_add(PHASE_THREAD_REDUCTION, start);
+        record_thread_work(thread_id, thread_id, num_iterations, num_threads, busy, wait);
 
         //Clear thread memory
         mpf_clears(local_pi, dep_m, a, b, c, d, e, f, g, aux, NULL);   
     }
 
+    start = phase_clock();
     mpf_div_ui(pi, pi, 64);
+    phase_add(PHASE_FINAL, start);
 
     mpf_clear(ONE);        
 }
@@ -3,6 +3,8 @@
 #include <gmp.h>
 #include <omp.h>
 #include "../../Headers/Sequential/Chudnovsky.h"
+#include "../../Headers/Common/Checkpoint.h"
+#include "../../Headers/Common/Timers.h"
 
 #define A 13591409
 #define B 545140134
@@ -42,8 +44,8 @@
 
 
 /*
- * This method is used by ParallelChudnovskyAlgorithm threads
- * for computing the first value of dep_a
+ * This method computes the value of dep_a for any iteration
+ * directly from the factorials
  */
 void init_dep_a(mpf_t dep_a, int block_start){
     mpz_t factorial_n, dividend, divisor;
@@ -68,55 +70,69 @@ void init_dep_a(mpf_t dep_a, int block_start){
 }
 
 /*
- * This method provides an optimal distribution for each thread
- * based on the Chudnovsky iterations analysis.
- * It returns an array of three integers:
- *   distribution[0] -> block size
- *   distribution[1] -> block start
- *   distribution[2] -> block end 
+ * This method is used by ParallelChudnovskyAlgorithm threads
+ * for computing the first values of dep_a and dep_b of their blocks.
+ * Each thread computes the ratios of its own block and the seeds are obtained
+ * with a parallel prefix product of those ratios, so no thread repeats
+ * the factorial work of the previous blocks:
+ *      dep_a(block_start) = PRODUCT( dep_a(block_end) / dep_a(block_start) ), previous blocks
+ *      dep_b(block_start) = PRODUCT( c^(block_end - block_start) ),           previous blocks
+ * IMPORTANT: It must be called by every thread of the parallel region
  */
-int * get_thread_distribution(int num_threads, int thread_id, int num_iterations){
-    int * distribution, i, block_size, block_start, block_end, row, column; 
-    FILE * ratios_file;
-    float working_ratios[160][41];
-
-    //Open the working_ratios file 
-    ratios_file = fopen("Resources/working_ratios.txt", "r");
-    if(ratios_file == NULL){
-        printf("working_ratios.txt not found \n");
-        exit(-1);
-    } 
-
-    //Load the working_ratios matrix 
-    row = 0;
-    while (fscanf(ratios_file, "%f", &working_ratios[row][0]) == 1){
-        for (column = 1; column < 41; column++){
-            fscanf(ratios_file, "%f", &working_ratios[row][column]);
-        }
-        row++;
+void init_block_seeds_OMP(mpf_t dep_a, mpf_t dep_b, mpf_t c, int block_start, int block_end){
+    int thread_id, num_threads, step, current, next;
+    mpf_t * scan_a, * scan_b;
+
+    thread_id = omp_get_thread_num();
+    num_threads = omp_get_num_threads();
+
+    //Two buffers of num_threads values for the prefix products of dep_a and dep_b
+    #pragma omp single copyprivate(scan_a, scan_b)
+    {
+        scan_a = malloc(sizeof(mpf_t) * 2 * num_threads);
+        scan_b = malloc(sizeof(mpf_t) * 2 * num_threads);
     }
 
-    distribution = malloc(sizeof(int) * 3);
-    if(num_threads == 1){
-        distribution[0] = num_iterations;
-        distribution[1] = 0;
-        distribution[2] = num_iterations;
-        return distribution; 
+    mpf_inits(scan_a[thread_id], scan_a[num_threads + thread_id], NULL);
+    mpf_inits(scan_b[thread_id], scan_b[num_threads + thread_id], NULL);
+    get_dep_a_ratio(scan_a[thread_id], block_start, block_end);
+    mpf_pow_ui(scan_b[thread_id], c, block_end - block_start);
+    #pragma omp barrier
+
+    //Inclusive prefix product in log2(num_threads) steps
+    current = 0;
+    for(step = 1; step < num_threads; step <<= 1){
+        next = num_threads - current;
+        if (thread_id >= step){
+            mpf_mul(scan_a[next + thread_id], scan_a[current + thread_id - step], scan_a[current + thread_id]);
+            mpf_mul(scan_b[next + thread_id], scan_b[current + thread_id - step], scan_b[current + thread_id]);
+        } else {
+            mpf_set(scan_a[next + thread_id], scan_a[current + thread_id]);
+            mpf_set(scan_b[next + thread_id], scan_b[current + thread_id]);
+        }
+        current = next;
+        #pragma omp barrier
     }
 
-    block_size = working_ratios[thread_id][num_threads / 4] * num_iterations / 100;
-    block_start = 0;
-    for(i = 0; i < thread_id; i ++){
-        block_start += working_ratios[i][num_threads / 4] * num_iterations / 100;
+    //The seed of each block is the product of the previous blocks
+    if (thread_id == 0){
+        mpf_set_ui(dep_a, 1);
+        mpf_set_ui(dep_b, 1);
+    } else {
+        mpf_set(dep_a, scan_a[current + thread_id - 1]);
+        mpf_set(dep_b, scan_b[current + thread_id - 1]);
     }
-    block_end = block_start + block_size;
-    if (thread_id == num_threads -1) block_end = num_iterations;
-    
-    distribution[0] = block_size;
-    distribution[1] = block_start;
-    distribution[2] = block_end;
+    #pragma omp barrier
 
-    return distribution;
+    mpf_clears(scan_a[thread_id], scan_a[num_threads + thread_id], NULL);
+    mpf_clears(scan_b[thread_id], scan_b[num_threads + thread_id], NULL);
+    #pragma omp barrier
+
+    #pragma omp single
+    {
+        free(scan_a);
+        free(scan_b);
+    }
 }
 
 /*
@@ -124,41 +140,59 @@ int * get_thread_distribution(int num_threads, int thread_id, int num_iterations
  * Multiple threads can be used
  * The number of iterations is divided by blocks 
  * so each thread calculates a part of pi.  
+ * With --checkpoint its state is saved periodically (see Checkpoint)
  */
 void Chudnovsky_algorithm_OMP(mpf_t pi, int num_iterations, int num_threads){
     mpf_t e, c;
+    int block_size;
+    double start;
 
+    block_size = (num_iterations + num_threads - 1) / num_threads;
     mpf_init_set_ui(e, E);
     mpf_init_set_ui(c, C);
     mpf_neg(c, c);
     mpf_pow_ui(c, c, 3);
 
+    init_checkpoint(CHECKPOINT_CHUDNOVSKY, num_iterations, num_threads, 4);
+
     //Set the number of threads 
     omp_set_num_threads(num_threads);
 
     #pragma omp parallel 
     {   
-        int thread_id, i, block_size, block_start, block_end, factor_a, * distribution;
+        int thread_id, i, slot, block_start, block_end, factor_a;
+        double start, busy, wait;
         mpf_t local_pi, dep_a, dep_a_dividend, dep_a_divisor, dep_b, dep_c, aux;
 
         thread_id = omp_get_thread_num();
-        distribution = get_thread_distribution(num_threads, thread_id, num_iterations);
-        block_size = distribution[0];
-        block_start = distribution[1];
-        block_end = distribution[2];
+        block_start = thread_id * block_size;
+        block_end = block_start + block_size;
+        if (block_start > num_iterations) block_start = num_iterations;
+        if (block_end > num_iterations) block_end = num_iterations;
         
+        start = phase_clock();
         mpf_init_set_ui(local_pi, 0);    // private thread pi
-        mpf_inits(dep_a, dep_b, dep_a_dividend, dep_a_divisor, aux, NULL);
-        init_dep_a(dep_a, block_start);
-        mpf_pow_ui(dep_b, c, block_start);
-        mpf_init_set_ui(dep_c, B);
-        mpf_mul_ui(dep_c, dep_c, block_start);
-        mpf_add_ui(dep_c, dep_c, A);
+        mpf_inits(dep_a, dep_b, dep_c, dep_a_dividend, dep_a_divisor, aux, NULL);
+
+        //State saved in the checkpoints (see Checkpoint). 
+        //All the threads resume or none, as the seeds are computed by all of them
+        mpf_ptr state[] = {local_pi, dep_a, dep_b, dep_c};
+        slot = resume_checkpoint(block_start, &block_start, &block_end, state);
+        if (slot < 0){
+            init_block_seeds_OMP(dep_a, dep_b, c, block_start, block_end);
+            mpf_set_ui(dep_c, B);
+            mpf_mul_ui(dep_c, dep_c, block_start);
+            mpf_add_ui(dep_c, dep_c, A);
+            slot = open_checkpoint_slot(block_start, 1, block_start, block_end, NULL);
+        }
         factor_a = 12 * block_start;
+        busy = phase_add(PHASE_INIT, start);
 
         //First Phase -> Working on a local variable        
+        start = phase_clock();
         #pragma omp parallel for 
             for(i = block_start; i < block_end; i++){
+                checkpoint_poll(slot, i, state);
                 Chudnovsky_iteration(local_pi, i, dep_a, dep_b, dep_c, aux);
                 //Update dep_a:
                 mpf_set_ui(dep_a_dividend, factor_a + 10);
@@ -177,18 +211,26 @@ void Chudnovsky_algorithm_OMP(mpf_t pi, int num_iterations, int num_threads){
                 //Update dep_c:
                 mpf_add_ui(dep_c, dep_c, B);
             }
+        checkpoint_done(slot, state);
+        busy += phase_add(PHASE_SERIES, start);
 
         //Second Phase -> Accumulate the result in the global variable 
+        start = phase_clock();
         #pragma omp critical
         mpf_add(pi, pi, local_pi);
+        wait = phase_add(PHASE_THREAD_REDUCTION, start);
+        record_thread_work(thread_id, block_start, block_end, 1, busy, wait);
         
         //Clear thread memory
         mpf_clears(local_pi, dep_a, dep_b, dep_c, dep_a_dividend, dep_a_divisor, aux, NULL);   
     }
+    finish_checkpoint();
 
+    start = phase_clock();
     mpf_sqrt(e, e);
     mpf_mul_ui(e, e, D);
     mpf_div(pi, e, pi);    
+    phase_add(PHASE_FINAL, start);
     
     //Clear memory
     mpf_clears(c, e, NULL);
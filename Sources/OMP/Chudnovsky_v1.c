@@ -3,6 +3,7 @@
 #include <gmp.h>
 #include <omp.h>
 #include "../../Headers/Sequential/Chudnovsky_v1.h"
+#include "../../Headers/Common/Timers.h"
 
 
 #define A 13591409
@@ -10,11 +11,12 @@
 #define C 640320
 #define D 426880
 #define E 10005
+#define NUM_FACTORIALS 3
 
 /************************************************************************************
  * Miguel Pardo Navarro. 17/07/2021                                                 *
  * Chudnovsky formula implementation                                                *
- * This version computes all the factorials needed before performing the iterations *
+ * This version computes the factorials (n!, (3n)! and (6n)!) of every iteration    *
  * It allows to compute pi using multiple threads                                   *
  *                                                                                  *
  ************************************************************************************
@@ -47,11 +49,8 @@
  */
 void Chudnovsky_algorithm_v1_OMP(mpf_t pi, int num_iterations, int num_threads){
     mpf_t e, c;
-    int num_factorials, block_size;
-    
-    num_factorials = num_iterations * 6;
-    mpf_t factorials[num_factorials + 1];
-    get_factorials(factorials, num_factorials);
+    int block_size;
+    double start;
 
     block_size = (num_iterations + num_threads - 1) / num_threads;
     mpf_init_set_ui(e, E);
@@ -65,52 +64,67 @@ void Chudnovsky_algorithm_v1_OMP(mpf_t pi, int num_iterations, int num_threads){
     #pragma omp parallel 
     {   
         int thread_id, i, block_start, block_end;
+        double start, busy, wait;
         mpf_t local_pi, dep_a, dep_b, dep_c, dep_d, dep_e, dividend, divisor;
+        mpf_t factorials[NUM_FACTORIALS];
 
         thread_id = omp_get_thread_num();
         block_start = thread_id * block_size;
         block_end = block_start + block_size;
+        if (block_start > num_iterations) block_start = num_iterations;
         if (block_end > num_iterations) block_end = num_iterations;
 
+        //Each thread only keeps the factorials of its current iteration
+        start = phase_clock();
+        get_factorials(factorials, block_start);
+
         mpf_init_set_ui(local_pi, 0);    // private thread pi
         mpf_inits(dividend, divisor, NULL);
-        mpf_init_set(dep_a, factorials[block_start * 6]);
-        mpf_init_set(dep_b, factorials[block_start]);
+        mpf_init_set(dep_a, factorials[2]);
+        mpf_init_set(dep_b, factorials[0]);
         mpf_pow_ui(dep_b, dep_b, 3);
-        mpf_init_set(dep_c, factorials[block_start * 3]);
+        mpf_init_set(dep_c, factorials[1]);
         mpf_init_set_ui(dep_d, C);
         mpf_neg(dep_d, dep_d);
         mpf_pow_ui(dep_d, dep_d, block_start * 3);
         mpf_init_set_ui(dep_e, B);
         mpf_mul_ui(dep_e, dep_e, block_start);
         mpf_add_ui(dep_e, dep_e, A);
+        busy = phase_add(PHASE_INIT, start);
 
         //First Phase -> Working on a local variable        
+        start = phase_clock();
         #pragma omp parallel for 
             for(i = block_start; i < block_end; i++){
                 Chudnovsky_iteration_v1(local_pi, i, dep_a, dep_b, dep_c, dep_d, dep_e, dividend, divisor);
                 //Update dependencies
-                mpf_set(dep_a, factorials[6 * (i + 1)]);
-                mpf_pow_ui(dep_b, factorials[i + 1], 3);
-                mpf_set(dep_c, factorials[3 * (i + 1)]);
+                next_factorials(factorials, i);
+                mpf_set(dep_a, factorials[2]);
+                mpf_pow_ui(dep_b, factorials[0], 3);
+                mpf_set(dep_c, factorials[1]);
                 mpf_mul(dep_d, dep_d, c);
                 mpf_add_ui(dep_e, dep_e, B);
             }
-
+        busy += phase_add(PHASE_SERIES, start);
 
         //Second Phase -> Accumulate the result in the global variable 
+        start = phase_clock();
         #pragma omp critical
         mpf_add(pi, pi, local_pi);
+        wait = phase_add(PHASE_THREAD_REDUCTION, start);
+        record_thread_work(thread_id, block_start, block_end, 1, busy, wait);
         
         //Clear thread memory
+        clear_factorials(factorials);
         mpf_clears(local_pi, dep_a, dep_b, dep_c, dep_d, dep_e, dividend, divisor, NULL);   
     }
 
+    start = phase_clock();
     mpf_sqrt(e, e);
     mpf_mul_ui(e, e, D);
     mpf_div(pi, e, pi);    
+    phase_add(PHASE_FINAL, start);
     
     //Clear memory
-    clear_factorials(factorials, num_factorials);
     mpf_clears(c, e, NULL);
 }
@@ -3,6 +3,7 @@
 #include <gmp.h>
 #include <omp.h>
 #include "../../Headers/Sequential/Chudnovsky.h"
+#include "../../Headers/OMP/Chudnovsky.h"
 
 #define A 13591409
 #define B 545140134
@@ -41,32 +42,6 @@
  ************************************************************************************/
 
 
-/*
- * This method is used by ParallelChudnovskyAlgorithm threads
- * for computing the first value of dep_a
- */
-void init_dep_a_v2(mpf_t dep_a, int block_start){
-    mpz_t factorial_n, dividend, divisor;
-    mpf_t float_dividend, float_divisor;
-    mpz_inits(factorial_n, dividend, divisor, NULL);
-    mpf_inits(float_dividend, float_divisor, NULL);
-
-    mpz_fac_ui(factorial_n, block_start);
-    mpz_fac_ui(divisor, 3 * block_start);
-    mpz_fac_ui(dividend, 6 * block_start);
-
-    mpz_pow_ui(factorial_n, factorial_n, 3);
-    mpz_mul(divisor, divisor, factorial_n);
-
-    mpf_set_z(float_dividend, dividend);
-    mpf_set_z(float_divisor, divisor);
-
-    mpf_div(dep_a, float_dividend, float_divisor);
-
-    mpz_clears(factorial_n, dividend, divisor, NULL);
-    mpf_clears(float_dividend, float_divisor, NULL);
-}
-
 /*
  * Parallel Pi number calculation using the Chudnovsky algorithm
  * Multiple threads can be used
@@ -94,12 +69,12 @@ void Chudnovsky_algorithm_v2_OMP(mpf_t pi, int num_iterations, int num_threads){
         thread_id = omp_get_thread_num();
         block_start = thread_id * block_size;
         block_end = block_start + block_size;
+        if (block_start > num_iterations) block_start = num_iterations;
         if (block_end > num_iterations) block_end = num_iterations;
         
         mpf_init_set_ui(local_pi, 0);    // private thread pi
         mpf_inits(dep_a, dep_b, dep_a_dividend, dep_a_divisor, aux, NULL);
-        init_dep_a_v2(dep_a, block_start);
-        mpf_pow_ui(dep_b, c, block_start);
+        init_block_seeds_OMP(dep_a, dep_b, c, block_start, block_end);
         mpf_init_set_ui(dep_c, B);
         mpf_mul_ui(dep_c, dep_c, block_start);
         mpf_add_ui(dep_c, dep_c, A);
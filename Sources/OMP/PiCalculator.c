@@ -9,10 +9,17 @@
 #include "../../Headers/OMP/Chudnovsky_v1.h"
 #include "../../Headers/OMP/Chudnovsky.h"
 #include "../../Headers/Common/Check_decimals.h"
+#include "../../Headers/Common/Checkpoint.h"
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/Common/Output.h"
+#include "../../Headers/Common/Timers.h"
+#include "../../Headers/Common/Trace.h"
+#include "../../Headers/Common/Memory.h"
+#include "../../Headers/Common/Perf.h"
 
 double gettimeofday();
 
-void check_errors_OMP(int precision, int num_iterations, int num_threads, int algorithm){
+void check_errors_OMP(int precision, int num_iterations, int num_threads){
     if (precision <= 0){
         printf("  Precision should be greater than cero. \n\n");
         exit(-1);
@@ -22,14 +29,6 @@ void check_errors_OMP(int precision, int num_iterations, int num_threads, int al
         printf("  Try using a greater precision or lower threads number. \n\n");
         exit(-1);
     }
-    if (algorithm == 5){ 
-        // Last version of Chudnovksy is more efficient when threads and procs are 2 or multiples of four
-        if (num_threads > 2 && num_threads % 4 != 0){
-            printf("  The last version of Chudnovksy is not eficient with %d threads. \n", num_threads);
-            printf("  Try using 2 threads or multiples of four (4, 8, 12, 16, ..) \n\n");
-            exit(-1);
-        } 
-    }
 }
 
 void print_running_properties_OMP(int precision, int num_iterations, int num_threads){
@@ -39,22 +38,29 @@ void print_running_properties_OMP(int precision, int num_iterations, int num_thr
 }
 
 void calculate_Pi_OMP(int algorithm, int precision, int num_threads){
-    double execution_time;
+    double execution_time, setup_start;
     struct timeval t1, t2;
     mpf_t pi;
     int num_iterations, decimals_computed;
 
     gettimeofday(&t1, NULL);
+    if (run_options.memory) start_memory_accounting();
+    if (run_options.perf) start_perf_counters();
+    reset_phases();
+    if (run_options.trace_file != NULL) start_trace();
+    setup_start = phase_clock();
 
     //Set gmp float precision (in bits) and init pi
     mpf_set_default_prec(precision * 8); 
     mpf_init_set_ui(pi, 0); 
+    phase_add(PHASE_SETUP, setup_start);
     
     switch (algorithm)
     {
     case 0:
         num_iterations = precision * 0.84;
-        check_errors_OMP(precision, num_iterations, num_threads, algorithm);
+        check_errors_OMP(precision, num_iterations, num_threads);
+        check_checkpoint_options();
         printf("  Algorithm: BBP (First version) \n");
         print_running_properties_OMP(precision, num_iterations, num_threads);
         BBP_algorithm_v1_OMP(pi, num_iterations, num_threads);
@@ -62,7 +68,7 @@ void calculate_Pi_OMP(int algorithm, int precision, int num_threads){
 
     case 1:
         num_iterations = precision * 0.84;
-        check_errors_OMP(precision, num_iterations, num_threads, algorithm);
+        check_errors_OMP(precision, num_iterations, num_threads);
         printf("  Algorithm: BBP (Last version)\n");
         print_running_properties_OMP(precision, num_iterations, num_threads);      
         BBP_algorithm_OMP(pi, num_iterations, num_threads);
@@ -70,7 +76,8 @@ void calculate_Pi_OMP(int algorithm, int precision, int num_threads){
 
     case 2:
         num_iterations = precision / 3;
-        check_errors_OMP(precision, num_iterations, num_threads, algorithm);
+        check_errors_OMP(precision, num_iterations, num_threads);
+        check_checkpoint_options();
         printf("  Algorithm: Bellard (First version) \n");
         print_running_properties_OMP(precision, num_iterations, num_threads);
         Bellard_algorithm_v1_OMP(pi, num_iterations, num_threads);
@@ -78,7 +85,8 @@ void calculate_Pi_OMP(int algorithm, int precision, int num_threads){
 
     case 3:
         num_iterations = precision / 3;
-        check_errors_OMP(precision, num_iterations, num_threads, algorithm);
+        check_errors_OMP(precision, num_iterations, num_threads);
+        check_checkpoint_options();
         printf("  Algorithm: Bellard (Last version) \n");
         print_running_properties_OMP(precision, num_iterations, num_threads);
         Bellard_algorithm_OMP(pi, num_iterations, num_threads);
@@ -86,7 +94,8 @@ void calculate_Pi_OMP(int algorithm, int precision, int num_threads){
 
     case 4:
         num_iterations = (precision + 14 - 1) / 14;  //Division por exceso
-        check_errors_OMP(precision, num_iterations, num_threads, algorithm);
+        check_errors_OMP(precision, num_iterations, num_threads);
+        check_checkpoint_options();
         printf("  Algorithm: Chudnovsky  \n");
         print_running_properties_OMP(precision, num_iterations, num_threads);
         Chudnovsky_algorithm_v1_OMP(pi, num_iterations, num_threads);
@@ -94,7 +103,7 @@ void calculate_Pi_OMP(int algorithm, int precision, int num_threads){
 
     case 5:
         num_iterations = (precision + 14 - 1) / 14;  //Division por exceso
-        check_errors_OMP(precision, num_iterations, num_threads, algorithm);
+        check_errors_OMP(precision, num_iterations, num_threads);
         printf("  Algorithm: Chudnovsky (Last version) \n");
         print_running_properties_OMP(precision, num_iterations, num_threads);
         Chudnovsky_algorithm_OMP(pi, num_iterations, num_threads);
@@ -115,9 +124,22 @@ void calculate_Pi_OMP(int algorithm, int precision, int num_threads){
 
     gettimeofday(&t2, NULL);
     execution_time = ((t2.tv_sec - t1.tv_sec) * 1000000u +  t2.tv_usec - t1.tv_usec)/1.e6; 
-    decimals_computed = check_decimals(pi);
+    if (run_options.output_file != NULL) decimals_computed = write_and_check_decimals(pi, precision);
+    else decimals_computed = check_decimals(pi);
     mpf_clear(pi);
     printf("  Match the first %d decimals. \n", decimals_computed);
+    print_mismatch();
     printf("  Execution time: %f seconds. \n", execution_time);
+    collect_memory_counters();
+    collect_perf_counters();
+    print_phases();
+    print_memory(1);
+    print_perf(1);
+    print_imbalance(run_options.imbalance);
+    if (run_options.report_file != NULL){
+        write_run_report(run_options.report_file, "OMP", algorithm, precision, num_iterations, 1, num_threads, 
+                            execution_time, decimals_computed);
+    }
+    if (run_options.trace_file != NULL) save_trace(run_options.trace_file);
     printf("\n");
 }
\ No newline at end of file
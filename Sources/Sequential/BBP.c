@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <gmp.h>
+#include "../../Headers/Common/Checkpoint.h"
+#include "../../Headers/Common/Timers.h"
 
 #define QUOTIENT 0.0625
 
@@ -64,20 +66,37 @@ void BBP_iteration(mpf_t pi, int n, mpf_t dep_m,
 /*
  * Sequential Pi number calculation using the BBP algorithm
  * Single thread implementation
+ * With --checkpoint its state is saved periodically (see Checkpoint)
  */
 void BBP_algorithm(mpf_t pi, int num_iterations){   
-    int i;
+    int i, slot, first, end;
+    double start;
     mpf_t dep_m, quotient, quot_a, quot_b, quot_c, quot_d, aux;
 
+    start = phase_clock();
     mpf_inits(quot_a, quot_b, quot_c, quot_d, aux, NULL);
     mpf_init_set_ui(dep_m, 1);          // m = (1/16)^n
     mpf_init_set_d(quotient, QUOTIENT); // quotient = (1/16)   
 
-    for(i = 0; i < num_iterations; i++){ 
+    //State saved in the checkpoints (see Checkpoint)
+    mpf_ptr state[] = {pi, dep_m};
+    init_checkpoint(CHECKPOINT_BBP, num_iterations, 1, 2);
+    first = 0;
+    end = num_iterations;
+    slot = resume_checkpoint(0, &first, &end, state);
+    if (slot < 0) slot = open_checkpoint_slot(0, 1, 0, end, state);
+    phase_add(PHASE_INIT, start);
+
+    start = phase_clock();
+    for(i = first; i < end; i++){ 
+        checkpoint_poll(slot, i, state);
         BBP_iteration(pi, i, dep_m, quot_a, quot_b, quot_c, quot_d, aux);   
         // Update dependencies:  
         mpf_mul(dep_m, dep_m, quotient);
     }
+    checkpoint_done(slot, state);
+    finish_checkpoint();
+    phase_add(PHASE_SERIES, start);
 
     mpf_clears(dep_m, quotient, quot_a, quot_b, quot_c, quot_d, aux, NULL);
 }
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <gmp.h>
+#include "../../Headers/Common/Timers.h"
 
 #define QUOTIENT 0.0625
 
@@ -66,13 +67,16 @@ void BBP_iteration_v1(mpf_t pi, int n, mpf_t quotient){
  */
 void BBP_algorithm_v1(mpf_t pi, int num_iterations){
     int i;
+    double start;
     mpf_t quotient;           
 
     mpf_init_set_d(quotient, QUOTIENT); // quotient = (1/16)      
 
+    start = phase_clock();
     for(i = 0; i < num_iterations; i++){
         BBP_iteration_v1(pi, i, quotient);    
     }
+    phase_add(PHASE_SERIES, start);
 
     //Clear memory
     mpf_clear(quotient);
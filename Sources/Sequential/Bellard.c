@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <gmp.h>
 #include "../../Headers/Sequential/Bellard_v1.h"
+#include "../../Headers/Common/Timers.h"
 
 
 /************************************************************************************
@@ -43,6 +44,7 @@
  */
 void Bellard_algorithm(mpf_t pi, int num_iterations){   
     int i, dep_a, dep_b, next_i;
+    double start;
     mpf_t dep_m, a, b, c, d, e, f, g, aux, ONE;    
 
     dep_a = 0, dep_b = 0;       
@@ -50,6 +52,7 @@ void Bellard_algorithm(mpf_t pi, int num_iterations){
     mpf_init_set_ui(ONE, 1);
     mpf_inits(a, b, c, d, e, f, g, aux, NULL);
 
+    start = phase_clock();
     for(i = 0; i < num_iterations; i++){ 
         Bellard_iteration(pi, i, dep_m, a, b, c, d, e, f, g, aux, dep_a, dep_b);   
         // Update dependencies for next iteration: 
@@ -60,8 +63,11 @@ void Bellard_algorithm(mpf_t pi, int num_iterations){
         dep_a += 4;
         dep_b += 10;
     }
+    phase_add(PHASE_SERIES, start);
 
+    start = phase_clock();
     mpf_div_ui(pi, pi, 64);
+    phase_add(PHASE_FINAL, start);
     
     mpf_clears(dep_m, a, b, c, d, e, f, g, aux, ONE, NULL);
 }
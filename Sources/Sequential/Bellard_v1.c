@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <gmp.h>
+#include "../../Headers/Common/Timers.h"
 
 
 /************************************************************************************
@@ -80,6 +81,7 @@ void Bellard_iteration(mpf_t pi, int n, mpf_t m, mpf_t a, mpf_t b, mpf_t c, mpf_
  */
 void Bellard_algorithm_v1(mpf_t pi, int num_iterations){   
     int i, dep_a, dep_b;
+    double start;
     mpf_t dep_m, jump, a, b, c, d, e, f, g, aux;    
 
     dep_a = 0, dep_b = 0;       
@@ -88,6 +90,7 @@ void Bellard_algorithm_v1(mpf_t pi, int num_iterations){
     mpf_init_set_ui(dep_m, 1);          // dep_m = ((-1)^n)/1024)
     mpf_inits(a, b, c, d, e, f, g, aux, NULL);
 
+    start = phase_clock();
     for(i = 0; i < num_iterations; i++){ 
         Bellard_iteration(pi, i, dep_m, a, b, c, d, e, f, g, aux, dep_a, dep_b);   
         // Update dependencies for next iteration: 
@@ -96,8 +99,11 @@ void Bellard_algorithm_v1(mpf_t pi, int num_iterations){
         dep_a += 4;
         dep_b += 10;
     }
+    phase_add(PHASE_SERIES, start);
 
+    start = phase_clock();
     mpf_div_ui(pi, pi, 64);
+    phase_add(PHASE_FINAL, start);
     
     mpf_clears(dep_m, jump, a, b, c, d, e, f, g, aux, NULL);
 }
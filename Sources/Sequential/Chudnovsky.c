@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <gmp.h>
+#include "../../Headers/Common/Checkpoint.h"
+#include "../../Headers/Common/Timers.h"
 
 #define A 13591409
 #define B 545140134
@@ -50,14 +52,74 @@ void Chudnovsky_iteration(mpf_t pi, int n, mpf_t dep_a, mpf_t dep_b,
     mpf_add(pi, pi, aux);
 }
 
+/*
+ * This method computes the exact product of the dep_a ratios from first to last (not included)
+ * by binary splitting. The numerator is stored in dividend and the denominator in divisor:
+ *      dividend = PRODUCT( (12n + 10)(12n + 6)(12n + 2) ),  first <= n < last
+ *      divisor  = PRODUCT( (n + 1)^3 ),                     first <= n < last
+ */
+void get_dep_a_ratio_terms(mpz_t dividend, mpz_t divisor, int first, int last){
+    int middle;
+    mpz_t right_dividend, right_divisor;
+
+    if (last - first <= 0){
+        mpz_set_ui(dividend, 1);
+        mpz_set_ui(divisor, 1);
+        return;
+    }
+    if (last - first == 1){
+        mpz_set_ui(dividend, 12 * first + 10);
+        mpz_mul_ui(dividend, dividend, 12 * first + 6);
+        mpz_mul_ui(dividend, dividend, 12 * first + 2);
+        mpz_set_ui(divisor, first + 1);
+        mpz_pow_ui(divisor, divisor, 3);
+        return;
+    }
+
+    middle = first + (last - first) / 2;
+    mpz_inits(right_dividend, right_divisor, NULL);
+    get_dep_a_ratio_terms(dividend, divisor, first, middle);
+    get_dep_a_ratio_terms(right_dividend, right_divisor, middle, last);
+    mpz_mul(dividend, dividend, right_dividend);
+    mpz_mul(divisor, divisor, right_divisor);
+    mpz_clears(right_dividend, right_divisor, NULL);
+}
+
+/*
+ * This method computes the ratio between dep_a(last) and dep_a(first):
+ *                  dep_a(last)
+ *      ratio = ------------------
+ *                  dep_a(first)
+ * so a block of iterations can be seeded from the previous one without
+ * computing the factorials again.
+ */
+void get_dep_a_ratio(mpf_t ratio, int first, int last){
+    mpz_t dividend, divisor;
+    mpf_t float_divisor;
+
+    mpz_inits(dividend, divisor, NULL);
+    mpf_init(float_divisor);
+
+    get_dep_a_ratio_terms(dividend, divisor, first, last);
+    mpf_set_z(ratio, dividend);
+    mpf_set_z(float_divisor, divisor);
+    mpf_div(ratio, ratio, float_divisor);
+
+    mpz_clears(dividend, divisor, NULL);
+    mpf_clear(float_divisor);
+}
+
 /*
  * Sequential Pi number calculation using the Chudnovsky algorithm
  * Single thread implementation
+ * With --checkpoint its state is saved periodically (see Checkpoint)
  */
 void Chudnovsky_algorithm(mpf_t pi, int num_iterations){
-    int i, factor_a;
+    int i, slot, first, end, factor_a;
+    double start;
     mpf_t dep_a, dep_a_dividend, dep_a_divisor, dep_b, dep_c, e, c, aux;
 
+    start = phase_clock();
     mpf_inits(dep_a_dividend, dep_a_divisor, aux, NULL);
     mpf_init_set_ui(dep_a, 1);
     mpf_init_set_ui(dep_b, 1);
@@ -67,7 +129,18 @@ void Chudnovsky_algorithm(mpf_t pi, int num_iterations){
     mpf_neg(c, c);
     mpf_pow_ui(c, c, 3);
 
-    for(i = 0; i < num_iterations; i ++){
+    //State saved in the checkpoints (see Checkpoint)
+    mpf_ptr state[] = {pi, dep_a, dep_b, dep_c};
+    init_checkpoint(CHECKPOINT_CHUDNOVSKY, num_iterations, 1, 4);
+    first = 0;
+    end = num_iterations;
+    slot = resume_checkpoint(0, &first, &end, state);
+    if (slot < 0) slot = open_checkpoint_slot(0, 1, 0, end, state);
+    phase_add(PHASE_INIT, start);
+
+    start = phase_clock();
+    for(i = first; i < end; i ++){
+        checkpoint_poll(slot, i, state);
         Chudnovsky_iteration(pi, i, dep_a, dep_b, dep_c, aux);
         //Update dep_a:
         factor_a = 12 * i;
@@ -86,10 +159,15 @@ void Chudnovsky_algorithm(mpf_t pi, int num_iterations){
         //Update dep_c:
         mpf_add_ui(dep_c, dep_c, B);
     }
+    checkpoint_done(slot, state);
+    finish_checkpoint();
+    phase_add(PHASE_SERIES, start);
 
+    start = phase_clock();
     mpf_sqrt(e, e);
     mpf_mul_ui(e, e, D);
     mpf_div(pi, e, pi);    
+    phase_add(PHASE_FINAL, start);
     
     //Clear memory
     mpf_clears(dep_a, dep_a_dividend, dep_a_divisor, dep_b, dep_c, e, c, aux, NULL);
@@ -1,17 +1,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <gmp.h>
+#include "../../Headers/Common/Timers.h"
 
 #define A 13591409
 #define B 545140134
 #define C 640320
 #define D 426880
 #define E 10005
+#define NUM_FACTORIALS 3
 
 /************************************************************************************
  * Miguel Pardo Navarro. 17/07/2021                                                 *
  * First version of Chudnovsky formula                                              *
- * This version computes all the factorials needed before performing the iterations *
+ * This version computes the factorials (n!, (3n)! and (6n)!) of every iteration    *
  * It computes pi with a single thread                                              *
  *                                                                                  *
  ************************************************************************************
@@ -36,29 +38,54 @@
  ************************************************************************************/
 
 /*
- * This method calculates the factorials from 0 to num_factorials (included) 
- * and stores them in their corresponding vector position (factorials[n] = n!): 
- * factorials[0] = 1, factorials[1] = 1, factorials[2] = 2, factorials[3] = 6, etc.
- * The computation is performed with a single thread. 
+ * This method calculates the factorials needed by the iteration n 
+ * and stores them in their corresponding vector position: 
+ * factorials[0] = n!, factorials[1] = (3n)!, factorials[2] = (6n)!
+ * They are built as integers with mpz_fac_ui (prime swing products), 
+ * so each thread can get the factorials of its first iteration on its own.
+ * IMPORTANT: factorials must have NUM_FACTORIALS positions
  */
-void get_factorials(mpf_t * factorials, int num_factorials){
+void get_factorials(mpf_t * factorials, int n){
+    mpz_t factorial;
+    mpz_init(factorial);
+
+    mpz_fac_ui(factorial, n);
+    mpf_init(factorials[0]);
+    mpf_set_z(factorials[0], factorial);
+
+    mpz_fac_ui(factorial, 3 * n);
+    mpf_init(factorials[1]);
+    mpf_set_z(factorials[1], factorial);
+
+    mpz_fac_ui(factorial, 6 * n);
+    mpf_init(factorials[2]);
+    mpf_set_z(factorials[2], factorial);
+
+    mpz_clear(factorial);
+}
+
+/*
+ * This method updates the factorials of the iteration n 
+ * to the factorials of the iteration n + 1: 
+ * factorials[0] = (n + 1)!, factorials[1] = (3n + 3)!, factorials[2] = (6n + 6)!
+ */
+void next_factorials(mpf_t * factorials, int n){
     int i;
-    mpf_t f;
-    mpf_init_set_ui(f, 1);
-    mpf_init_set_ui(factorials[0], 1);
-    for(i = 1; i <= num_factorials; i++){
-        mpf_mul_ui(f, f, i);
-        mpf_init_set(factorials[i], f);
+    mpf_mul_ui(factorials[0], factorials[0], n + 1);
+    for(i = 3 * n + 1; i <= 3 * n + 3; i++){
+        mpf_mul_ui(factorials[1], factorials[1], i);
+    }
+    for(i = 6 * n + 1; i <= 6 * n + 6; i++){
+        mpf_mul_ui(factorials[2], factorials[2], i);
     }
-    mpf_clear(f);
 }
 
 /*
  * This method clears the factorials computed and stored in mpf_t * factorials
  */
-void clear_factorials(mpf_t * factorials, int num_factorials){
+void clear_factorials(mpf_t * factorials){
     int i;
-    for(i = 0; i <= num_factorials; i++){
+    for(i = 0; i < NUM_FACTORIALS; i++){
         mpf_clear(factorials[i]);
     }
 }
@@ -83,10 +110,11 @@ void Chudnovsky_iteration_v1(mpf_t pi, int n, mpf_t dep_a, mpf_t dep_b, mpf_t de
  * Single thread implementation
  */
 void Chudnovsky_algorithm_v1(mpf_t pi, int num_iterations){
-    int num_factorials, i; 
-    num_factorials = (num_iterations * 6) + 2;
-    mpf_t factorials[num_factorials + 1];
-    get_factorials(factorials, num_factorials);   
+    int i; 
+    double start;
+    mpf_t factorials[NUM_FACTORIALS];
+    start = phase_clock();
+    get_factorials(factorials, 0);   
 
     mpf_t dep_a, dep_b, dep_c, dep_d, dep_e, e, c, dividend, divisor;
     mpf_inits(dividend, divisor, NULL);
@@ -99,22 +127,29 @@ void Chudnovsky_algorithm_v1(mpf_t pi, int num_iterations){
     mpf_init_set_ui(c, C);
     mpf_neg(c, c);
     mpf_pow_ui(c, c, 3);
+    phase_add(PHASE_INIT, start);
 
+    start = phase_clock();
     for(i = 0; i < num_iterations; i ++){
         Chudnovsky_iteration_v1(pi, i, dep_a, dep_b, dep_c, dep_d, dep_e, dividend, divisor);
         //Update dependencies
-        mpf_set(dep_a, factorials[6 * (i + 1)]);
-        mpf_pow_ui(dep_b, factorials[i + 1], 3);
-        mpf_set(dep_c, factorials[3 * (i + 1)]);
+        next_factorials(factorials, i);
+        mpf_set(dep_a, factorials[2]);
+        mpf_pow_ui(dep_b, factorials[0], 3);
+        mpf_set(dep_c, factorials[1]);
         mpf_mul(dep_d, dep_d, c);
         mpf_add_ui(dep_e, dep_e, B);
     }
+    phase_add(PHASE_SERIES, start);
+
+    start = phase_clock();
     mpf_sqrt(e, e);
     mpf_mul_ui(e, e, D);
     mpf_div(pi, e, pi);    
+    phase_add(PHASE_FINAL, start);
     
     //Clear memory
-    clear_factorials(factorials, num_factorials);
+    clear_factorials(factorials);
     mpf_clears(dep_a, dep_b, dep_c, dep_d, dep_e, c, e, dividend, divisor, NULL);
 
 }
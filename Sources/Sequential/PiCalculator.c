@@ -9,6 +9,13 @@
 #include "../../Headers/Sequential/Chudnovsky_v1.h"
 #include "../../Headers/Sequential/Chudnovsky.h"
 #include "../../Headers/Common/Check_decimals.h"
+#include "../../Headers/Common/Checkpoint.h"
+#include "../../Headers/Common/Options.h"
+#include "../../Headers/Common/Output.h"
+#include "../../Headers/Common/Timers.h"
+#include "../../Headers/Common/Trace.h"
+#include "../../Headers/Common/Memory.h"
+#include "../../Headers/Common/Perf.h"
 
 double gettimeofday();
 
@@ -25,22 +32,29 @@ void print_running_properties(int precision, int num_iterations){
 }
 
 void calculate_Pi(int algorithm, int precision){
-    double execution_time;
+    double execution_time, setup_start;
     struct timeval t1, t2;
     mpf_t pi;
     int num_iterations, decimals_computed;
     
     gettimeofday(&t1, NULL);
+    if (run_options.memory) start_memory_accounting();
+    if (run_options.perf) start_perf_counters();
+    reset_phases();
+    if (run_options.trace_file != NULL) start_trace();
+    setup_start = phase_clock();
 
     //Set gmp float precision (in bits) and init pi
     mpf_set_default_prec(precision * 8); 
     mpf_init_set_ui(pi, 0); 
+    phase_add(PHASE_SETUP, setup_start);
     
     switch (algorithm)
     {
     case 0:
         num_iterations = precision * 0.84;
         check_errors(precision, num_iterations);
+        check_checkpoint_options();
         printf("  Algorithm: BBP (First version) \n");
         print_running_properties(precision, num_iterations);
         BBP_algorithm_v1(pi, num_iterations);
@@ -57,6 +71,7 @@ void calculate_Pi(int algorithm, int precision){
     case 2:
         num_iterations = precision / 3;
         check_errors(precision, num_iterations);
+        check_checkpoint_options();
         printf("  Algorithm: Bellard (First version) \n");
         print_running_properties(precision, num_iterations);
         Bellard_algorithm_v1(pi, num_iterations);
@@ -65,6 +80,7 @@ void calculate_Pi(int algorithm, int precision){
     case 3:
         num_iterations = precision / 3;
         check_errors(precision, num_iterations);
+        check_checkpoint_options();
         printf("  Algorithm: Bellard (Last version) \n");
         print_running_properties(precision, num_iterations);
         Bellard_algorithm(pi, num_iterations);
@@ -73,6 +89,7 @@ void calculate_Pi(int algorithm, int precision){
     case 4:
         num_iterations = (precision + 14 - 1) / 14;  //Division por exceso
         check_errors(precision, num_iterations);
+        check_checkpoint_options();
         printf("  Algorithm: Chudnovsky (First version) \n");
         print_running_properties(precision, num_iterations);
         Chudnovsky_algorithm_v1(pi, num_iterations);
@@ -101,9 +118,21 @@ void calculate_Pi(int algorithm, int precision){
 
     gettimeofday(&t2, NULL);
     execution_time = ((t2.tv_sec - t1.tv_sec) * 1000000u +  t2.tv_usec - t1.tv_usec)/1.e6; 
-    decimals_computed = check_decimals(pi);
+    if (run_options.output_file != NULL) decimals_computed = write_and_check_decimals(pi, precision);
+    else decimals_computed = check_decimals(pi);
     mpf_clear(pi);
     printf("  Match the first %d decimals \n", decimals_computed);
+    print_mismatch();
     printf("  Execution time: %f seconds \n", execution_time);
+    collect_memory_counters();
+    collect_perf_counters();
+    print_phases();
+    print_memory(0);
+    print_perf(0);
+    if (run_options.report_file != NULL){
+        write_run_report(run_options.report_file, "Sequential", algorithm, precision, num_iterations, 1, 1, 
+                            execution_time, decimals_computed);
+    }
+    if (run_options.trace_file != NULL) save_trace(run_options.trace_file);
     printf("\n");
 }
\ No newline at end of file
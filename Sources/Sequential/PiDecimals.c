@@ -2,11 +2,13 @@
 #include <stdlib.h>
 #include "../../Headers/Sequential/PiCalculator.h"
 #include "../../Headers/Common/Print_title.h"
+#include "../../Headers/Common/Options.h"
 
 
 int incorrect_params(char* exec_name){
     printf("  Number of params are not correct. Try with:\n");
-    printf("    %s algorithm precision \n", exec_name);
+    printf("    %s algorithm precision [options] \n", exec_name);
+    print_options_usage();
     printf("\n");
 }
 
@@ -17,7 +19,7 @@ int main(int argc, char **argv){
     printf("\n");
 
     //Check the number of parameters are correct
-    if(argc != 3){
+    if(argc < 3 || parse_options(argc, argv, 3) != 0){
         incorrect_params(argv[0]);
         exit(-1);
     }
@@ -5,28 +5,44 @@ error=""
 RED_OUTPUT="tput setaf 1"
 GREEN_OUTPUT="tput setaf 2"
 RESET_OUTPUT="tput sgr0"
+#With "counters", the mpf operations are also counted with --memory (see Sources/Counters/Operations.c)
+COUNTERS=""
+if [ "$2" = "counters" ]; then
+    COUNTERS="Sources/Counters/*.c -Wl,--wrap=__gmpf_mul,--wrap=__gmpf_mul_ui,--wrap=__gmpf_div,--wrap=__gmpf_div_ui,--wrap=__gmpf_add,--wrap=__gmpf_add_ui,--wrap=__gmpf_sub"
+fi
 
 errors(){
-    echo "params are not correct. They should be: ./compile.sh program"
+    echo "params are not correct. They should be: ./compile.sh program [counters]"
     echo "  if program is Sequential -> compile sequential version of PiDecimalsGMP"
     echo "  if program is OMP -> compile parallel OMP version of PiDecimalsGMP "
     echo "  if program is MPI -> compile parallel bybrid OMP and MPI version of PiDecimalsGMP "
+    echo "  if program is Benchmark -> compile the benchmark of the algorithms of PiDecimalsGMP "
+    echo "  if program is Microbenchmark -> compile the microbenchmark of the kernels of PiDecimalsGMP "
+    echo "  with counters -> also count the mpf mul/div/add calls with --memory "
     exit 1
 }
 
 #CHECK PARAMS
-if [ "$#" -ne 1 ]; then
+if [ "$#" -lt 1 ] || [ "$#" -gt 2 ] || ([ "$#" -eq 2 ] && [ "$2" != "counters" ]); then
    errors
 fi
 
 if [ "$program" = "Sequential" ]; then
-	error=$(gcc -o sequential.x Sources/Sequential/*.c Sources/Common/*.c -lgmp 2>&1 1>/dev/null)
+	error=$(gcc -o sequential.x Sources/Sequential/*.c Sources/Common/*.c -lgmp -pthread $COUNTERS 2>&1 1>/dev/null)
 
 elif [ "$program" = "OMP" ]; then
-	error=$(gcc -fopenmp -o parallelOMP.x Sources/OMP/*.c Sources/Sequential/BBP*.c Sources/Sequential/Bellard*.c Sources/Sequential/Chudnovsky*.c Sources/Common/*.c -lgmp 2>&1 1>/dev/null)
+	error=$(gcc -fopenmp -o parallelOMP.x Sources/OMP/*.c Sources/Sequential/BBP*.c Sources/Sequential/Bellard*.c Sources/Sequential/Chudnovsky*.c Sources/Common/*.c -lgmp -pthread $COUNTERS 2>&1 1>/dev/null)
 
 elif [ "$program" = "MPI" ]; then 
-	error=$(mpicc -fopenmp -o parallelMPI.x Sources/MPI/*.c Sources/Sequential/BBP*.c Sources/Sequential/Bellard*.c Sources/Sequential/Chudnovsky*.c Sources/Common/*.c -lgmp 2>&1 1>/dev/null)
+	error=$(mpicc -fopenmp -o parallelMPI.x Sources/MPI/*.c Sources/Sequential/BBP*.c Sources/Sequential/Bellard*.c Sources/Sequential/Chudnovsky*.c Sources/Common/*.c -lgmp -pthread $COUNTERS 2>&1 1>/dev/null)
+
+elif [ "$program" = "Benchmark" ]; then 
+	revision=$(git describe --always --dirty 2>/dev/null || echo unknown)
+	error=$(gcc -fopenmp -DGIT_REVISION="\"$revision\"" -o benchmark.x Sources/Benchmark/*.c Sources/OMP/BBP*.c Sources/OMP/Bellard*.c Sources/OMP/Chudnovsky*.c Sources/Sequential/BBP*.c Sources/Sequential/Bellard*.c Sources/Sequential/Chudnovsky*.c Sources/Common/*.c -lgmp -pthread $COUNTERS -lm 2>&1 1>/dev/null)
+
+elif [ "$program" = "Microbenchmark" ]; then 
+	revision=$(git describe --always --dirty 2>/dev/null || echo unknown)
+	error=$(mpicc -fopenmp -DGIT_REVISION="\"$revision\"" -o microbenchmark.x Sources/Microbenchmark/*.c Sources/Benchmark/Benchmark.c Sources/Benchmark/Regression.c Sources/MPI/OperationsMPI.c Sources/OMP/BBP*.c Sources/OMP/Bellard*.c Sources/OMP/Chudnovsky*.c Sources/Sequential/BBP*.c Sources/Sequential/Bellard*.c Sources/Sequential/Chudnovsky*.c Sources/Common/*.c -lgmp -pthread -lm $COUNTERS 2>&1 1>/dev/null)
 
 else
     errors